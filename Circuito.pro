@@ -11,6 +11,12 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 TARGET = Circuito
 TEMPLATE = app
 
+# A geracao da tabela verdade usa std::thread
+CONFIG += c++17 thread
+
+# A compilacao do circuito para codigo nativo usa dlopen
+unix: LIBS += -ldl
+
 # The following define makes your compiler emit warnings if you use
 # any feature of Qt which as been marked as deprecated (the exact warnings
 # depend on your compiler). Please consult the documentation of the
@@ -24,21 +30,39 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 
 SOURCES += main.cpp\
+    arquivo.cpp \
     bool3S.cpp \
+    bytecode.cpp \
     circuito_incompleto.cpp \
+    compilado.cpp \
+    contexto.cpp \
+    exportar.cpp \
     maincircuito.cpp \
+    modelotabela.cpp \
     modificarporta.cpp \
     newcircuito.cpp \
     modificarsaida.cpp \
-    port_incompleto.cpp
+    netlist.cpp \
+    port_incompleto.cpp \
+    tabela.cpp
 
 HEADERS  += maincircuito.h \
+    arquivo.h \
     bool3S.h \
+    bool3S_64.h \
+    bytecode.h \
     circuito.h \
+    circuitoconst.h \
+    compilado.h \
+    contexto.h \
+    exportar.h \
+    modelotabela.h \
     modificarporta.h \
     newcircuito.h \
     modificarsaida.h \
-    port.h
+    netlist.h \
+    port.h \
+    tabela.h
 
 FORMS    += maincircuito.ui \
     modificarporta.ui \
@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include "arquivo.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ARQUIVO_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//Autores:  Luisa de Moura Galvão Mathias
+//          Marcos Paulo Barbosa
+
+///
+/// ARQUIVO MAPEADO EM MEMORIA
+///
+
+ArquivoMapeado::ArquivoMapeado(): inicio(""), tam(0), mapa(nullptr), tam_mapa(0), copia() {}
+
+ArquivoMapeado::~ArquivoMapeado()
+{
+  fechar();
+}
+
+void ArquivoMapeado::fechar()
+{
+#ifdef ARQUIVO_POSIX
+  if (mapa!=nullptr) munmap(mapa, tam_mapa);
+#endif
+  mapa = nullptr;
+  tam_mapa = 0;
+  copia.clear();
+  inicio = "";
+  tam = 0;
+}
+
+bool ArquivoMapeado::abrir(const std::string& arq)
+{
+  fechar();
+
+#ifdef ARQUIVO_POSIX
+  int fd = open(arq.c_str(), O_RDONLY);
+  if (fd<0) return false;
+  struct stat info;
+  if (fstat(fd, &info)!=0 || !S_ISREG(info.st_mode))
+  {
+    close(fd);
+    return false;
+  }
+  if (info.st_size==0)
+  {
+    // Arquivo vazio: nao ha o que mapear
+    close(fd);
+    return true;
+  }
+  void* m = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); // o mapeamento continua valido depois de fechar o descritor
+  if (m!=MAP_FAILED)
+  {
+    // O arquivo eh lido do inicio ao fim
+    madvise(m, size_t(info.st_size), MADV_SEQUENTIAL);
+    mapa = m;
+    tam_mapa = size_t(info.st_size);
+    inicio = static_cast<const char*>(m);
+    tam = tam_mapa;
+    return true;
+  }
+  // Se nao der para mapear, leh o arquivo como nos outros sistemas
+#endif
+
+  std::ifstream arqv(arq.c_str(), std::ios::binary);
+  if (!arqv.is_open()) return false;
+  arqv.seekg(0, std::ios::end);
+  std::streamoff n = arqv.tellg();
+  if (n<0) return false;
+  arqv.seekg(0, std::ios::beg);
+  copia.resize(size_t(n));
+  if (n>0 && !arqv.read(copia.data(), n)) return false;
+  inicio = (copia.empty() ? "" : copia.data());
+  tam = copia.size();
+  return true;
+}
+
+///
+/// ERRO DE LEITURA
+///
+
+std::string ErroLeitura::texto() const
+{
+  if (linha<=0) return mensagem;
+  return "linha " + std::to_string(linha) + ", coluna " + std::to_string(coluna) + ": " + mensagem;
+}
+
+///
+/// LEITOR DE TEXTO
+///
+
+// Retorna true se c eh um espaco, tabulacao ou fim de linha (como isspace)
+static inline bool espaco(char c)
+{
+  return c==' ' || c=='\n' || c=='\t' || c=='\r' || c=='\v' || c=='\f';
+}
+
+LeitorTexto::LeitorTexto(const char* Inicio, const char* Fim):
+  p(Inicio), fim(Fim), ini_linha(Inicio), num_linha(1) {}
+
+void LeitorTexto::pularEspacos()
+{
+  while (p!=fim && espaco(*p))
+  {
+    if (*p=='\n')
+    {
+      num_linha++;
+      ini_linha = p+1;
+    }
+    p++;
+  }
+}
+
+bool LeitorTexto::terminou()
+{
+  pularEspacos();
+  return p==fim;
+}
+
+LeitorTexto::Posicao LeitorTexto::posicao()
+{
+  pularEspacos();
+  return Posicao{num_linha, int(p-ini_linha)+1};
+}
+
+void LeitorTexto::erro(const Posicao& P, const std::string& M) const
+{
+  throw ErroLeitura(P.linha, P.coluna, M);
+}
+
+void LeitorTexto::palavra(const char*& Inicio, size_t& Tam, const char* Descricao)
+{
+  Posicao pos = posicao();
+  if (p==fim) erro(pos, std::string("esperado ") + Descricao + ", encontrado o fim do arquivo");
+  Inicio = p;
+  while (p!=fim && !espaco(*p)) p++;
+  Tam = p-Inicio;
+}
+
+void LeitorTexto::palavra(const char* Esperada)
+{
+  const char* ini;
+  size_t n;
+  Posicao pos = posicao();
+  palavra(ini, n, Esperada);
+  if (std::string(ini, n)!=Esperada)
+  {
+    erro(pos, std::string("esperado ") + Esperada + ", encontrado " + std::string(ini, n));
+  }
+}
+
+long LeitorTexto::inteiro(const char* Descricao, long Minimo, long Maximo)
+{
+  Posicao pos = posicao();
+  const char* q = p;
+  bool negativo = false;
+  long valor = 0;
+
+  if (q!=fim && (*q=='-' || *q=='+'))
+  {
+    negativo = (*q=='-');
+    q++;
+  }
+  if (q==fim || *q<'0' || *q>'9')
+  {
+    if (p==fim) erro(pos, std::string("esperado ") + Descricao + ", encontrado o fim do arquivo");
+    erro(pos, std::string("esperado ") + Descricao);
+  }
+  // Depois de passar do maior valor absoluto aceito, os demais digitos sao apenas
+  // pulados (o resultado jah eh invalido), para nao estourar
+  const long limite = std::max(Maximo, -Minimo);
+  while (q!=fim && *q>='0' && *q<='9')
+  {
+    if (valor<=limite && valor<LONG_MAX/10) valor = 10*valor + (*q-'0');
+    q++;
+  }
+  if (negativo) valor = -valor;
+  if (valor<Minimo || valor>Maximo)
+  {
+    erro(pos, std::string(Descricao) + " invalido: " + std::string(p, q-p));
+  }
+  p = q;
+  return valor;
+}
+
+void LeitorTexto::caractere(char C, const char* Contexto)
+{
+  Posicao pos = posicao();
+  if (p==fim || *p!=C)
+  {
+    erro(pos, std::string("esperado '") + C + "' " + Contexto);
+  }
+  p++;
+}
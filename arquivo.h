@@ -0,0 +1,116 @@
+#ifndef _ARQUIVO_H_
+#define _ARQUIVO_H_
+
+//Autores:  Luisa de Moura Galvão Mathias
+//          Marcos Paulo Barbosa
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+///
+/// ARQUIVO MAPEADO EM MEMORIA
+///
+
+// Dah acesso ao conteudo de um arquivo como um bloco de bytes na memoria, sem copiar
+// Em sistemas POSIX o arquivo eh mapeado (mmap), de modo que soh as paginas lidas sao
+// carregadas e varios processos que abrem o mesmo arquivo compartilham a memoria
+// Nos demais sistemas (Windows), o arquivo eh lido inteiro para um vetor
+
+class ArquivoMapeado {
+private:
+  // O inicio e o tamanho do conteudo do arquivo
+  const char* inicio;
+  size_t tam;
+  // O endereco e o tamanho do mapeamento (nullptr se nao ha mapeamento)
+  void* mapa;
+  size_t tam_mapa;
+  // O conteudo do arquivo, quando nao eh possivel mapear
+  std::vector<char> copia;
+
+public:
+  ArquivoMapeado();
+  // Nao pode ser copiado (o mapeamento eh desfeito no destrutor)
+  ArquivoMapeado(const ArquivoMapeado&) = delete;
+  void operator=(const ArquivoMapeado&) = delete;
+  // Destrutor: apenas chama a funcao fechar()
+  ~ArquivoMapeado();
+
+  // Abre e mapeia o arquivo de nome arq (fechando o anterior)
+  // Retorna true se deu tudo OK; false se deu erro
+  bool abrir(const std::string& arq);
+  // Desfaz o mapeamento
+  void fechar();
+
+  // O conteudo do arquivo: dados()[0] a dados()[tamanho()-1]
+  const char* dados() const { return inicio; }
+  size_t tamanho() const { return tam; }
+};
+
+///
+/// ERRO DE LEITURA
+///
+
+// Descricao de um erro encontrado na leitura de um arquivo, lancada como excecao
+// pelos leitores de circuito
+struct ErroLeitura {
+  // Linha e coluna (a partir de 1) onde o erro foi encontrado, ou 0 se o erro nao
+  // se refere a uma posicao do arquivo
+  int linha, coluna;
+  std::string mensagem;
+
+  ErroLeitura(int L, int C, const std::string& M): linha(L), coluna(C), mensagem(M) {}
+
+  // Retorna a mensagem precedida pela posicao: "linha L, coluna C: mensagem"
+  std::string texto() const;
+};
+
+///
+/// LEITOR DE TEXTO
+///
+
+// Percorre um texto (por exemplo, o conteudo de um ArquivoMapeado) separando as
+// palavras e numeros, sempre separados por espacos, tabulacoes ou fim de linha, como
+// na leitura com o operador >> de uma stream. Guarda a linha e a coluna atuais para
+// as mensagens de erro
+// Os numeros sao convertidos diretamente a partir do texto, sem copias
+
+class LeitorTexto {
+private:
+  const char* p;          // proximo caractere a ser lido
+  const char* fim;        // final do texto
+  const char* ini_linha;  // inicio da linha atual
+  int num_linha;          // numero da linha atual (a partir de 1)
+
+public:
+  // Posicao no texto (linha e coluna a partir de 1)
+  struct Posicao {
+    int linha, coluna;
+  };
+
+  LeitorTexto(const char* Inicio, const char* Fim);
+
+  // Pula os espacos, tabulacoes e fins de linha
+  void pularEspacos();
+  // Retorna true se soh ha espacos ateh o final do texto
+  bool terminou();
+  // Retorna a posicao do proximo caractere que nao eh espaco
+  Posicao posicao();
+
+  // Leh uma palavra (sequencia de caracteres sem espacos) e retorna o seu inicio e tamanho
+  // Lanca ErroLeitura (esperado "Descricao") se o texto tiver terminado
+  void palavra(const char*& Inicio, size_t& Tam, const char* Descricao);
+  // Leh uma palavra e confere se eh igual a Esperada; caso contrario, lanca ErroLeitura
+  void palavra(const char* Esperada);
+  // Leh um numero inteiro (com sinal opcional) entre Minimo e Maximo; caso contrario,
+  // lanca ErroLeitura com Descricao
+  long inteiro(const char* Descricao, long Minimo, long Maximo);
+  // Leh um caractere (que nao eh espaco) e confere se eh igual a C; caso contrario,
+  // lanca ErroLeitura (esperado 'C' Contexto)
+  void caractere(char C, const char* Contexto);
+
+  // Lanca ErroLeitura com a mensagem M na posicao P
+  [[noreturn]] void erro(const Posicao& P, const std::string& M) const;
+};
+
+#endif // _ARQUIVO_H_
@@ -4,11 +4,14 @@
 //Autores:  Luisa de Moura Galvão Mathias
 //          Marcos Paulo Barbosa
 
+#include <cstdint>
 #include <iostream>
 
 // Criando um tipo de dados enumerado (bool3S) para representar um booleano com 3 estados:
 // bool3S::TRUE, bool3S::FALSE e bool3S::UNDEF
-enum class bool3S {
+// Ocupa um unico byte, e os valores (0, 1 e 2) sao usados como indices das tabelas
+// dos operadores
+enum class bool3S : uint8_t {
   UNDEF,
   FALSE,
   TRUE
@@ -16,18 +19,60 @@ enum class bool3S {
 
 // Os operadores logicos para a classe bool3S
 // Podem ser usados para facilitar a implementacao dos metodos de simulacao de portas logicas
+// Sao implementados por tabelas (consulta direta, sem testes) e definidos aqui (inline)
+// porque sao chamados para todas as portas em todas as simulacoes
+
+// As tabelas dos operadores, indexadas pelos valores dos operandos (UNDEF, FALSE, TRUE)
+inline constexpr bool3S TABELA_NOT3S[3] = {bool3S::UNDEF, bool3S::TRUE, bool3S::FALSE};
+inline constexpr bool3S TABELA_AND3S[3][3] = {
+  {bool3S::UNDEF, bool3S::FALSE, bool3S::UNDEF},
+  {bool3S::FALSE, bool3S::FALSE, bool3S::FALSE},
+  {bool3S::UNDEF, bool3S::FALSE, bool3S::TRUE}
+};
+inline constexpr bool3S TABELA_OR3S[3][3] = {
+  {bool3S::UNDEF, bool3S::UNDEF, bool3S::TRUE},
+  {bool3S::UNDEF, bool3S::FALSE, bool3S::TRUE},
+  {bool3S::TRUE,  bool3S::TRUE,  bool3S::TRUE}
+};
+inline constexpr bool3S TABELA_XOR3S[3][3] = {
+  {bool3S::UNDEF, bool3S::UNDEF, bool3S::UNDEF},
+  {bool3S::UNDEF, bool3S::FALSE, bool3S::TRUE},
+  {bool3S::UNDEF, bool3S::TRUE,  bool3S::FALSE}
+};
 
 // NOT 3S
-bool3S operator~(bool3S x);
+inline constexpr bool3S operator~(bool3S x) { return TABELA_NOT3S[uint8_t(x)]; }
 // AND 3S
-bool3S operator&(bool3S x1, bool3S x2);
-void operator&=(bool3S& x1, bool3S x2);
+inline constexpr bool3S operator&(bool3S x1, bool3S x2) { return TABELA_AND3S[uint8_t(x1)][uint8_t(x2)]; }
+inline void operator&=(bool3S& x1, bool3S x2) { x1 = x1 & x2; }
 // OR 3S
-bool3S operator|(bool3S x1, bool3S x2);
-void operator|=(bool3S& x1, bool3S x2);
+inline constexpr bool3S operator|(bool3S x1, bool3S x2) { return TABELA_OR3S[uint8_t(x1)][uint8_t(x2)]; }
+inline void operator|=(bool3S& x1, bool3S x2) { x1 = x1 | x2; }
 // XOR 3S
-bool3S operator^(bool3S x1, bool3S x2);
-void operator^=(bool3S& x1, bool3S x2);
+inline constexpr bool3S operator^(bool3S x1, bool3S x2) { return TABELA_XOR3S[uint8_t(x1)][uint8_t(x2)]; }
+inline void operator^=(bool3S& x1, bool3S x2) { x1 = x1 ^ x2; }
+
+// Os operadores aplicados a N valores (x[0] a x[N-1], N>=1): AND, OR e XOR de todos
+// Podem ser usados para simular as portas de varias entradas
+// O AND (OR) para no primeiro FALSE (TRUE), que define o resultado
+inline bool3S and3S(const bool3S* x, int N)
+{
+  bool3S out = x[0];
+  for (int i=1; i<N && out!=bool3S::FALSE; i++) out = out & x[i];
+  return out;
+}
+inline bool3S or3S(const bool3S* x, int N)
+{
+  bool3S out = x[0];
+  for (int i=1; i<N && out!=bool3S::TRUE; i++) out = out | x[i];
+  return out;
+}
+inline bool3S xor3S(const bool3S* x, int N)
+{
+  bool3S out = x[0];
+  for (int i=1; i<N; i++) out = out ^ x[i];
+  return out;
+}
 
 // Os operadores de incremento/decremento para a classe bool3S
 
@@ -0,0 +1,101 @@
+#ifndef _BOOL3S_64_H_
+#define _BOOL3S_64_H_
+
+//Autores:  Luisa de Moura Galvão Mathias
+//          Marcos Paulo Barbosa
+
+#include <cstdint>
+#include "bool3S.h"
+
+// Um tipo de dados (bool3S_64) que guarda 64 valores bool3S independentes, um em cada bit,
+// para simular 64 combinacoes de entrada de uma soh vez.
+// Cada valor eh representado por um bit em cada um de dois planos:
+// - plano T: o bit k vale 1 se o k-esimo valor eh bool3S::TRUE
+// - plano F: o bit k vale 1 se o k-esimo valor eh bool3S::FALSE
+// - bits T e F iguais a 0: o k-esimo valor eh bool3S::UNDEF
+// (os dois bits iguais a 1 nao representam nenhum valor e nunca devem ocorrer)
+struct bool3S_64 {
+  uint64_t T;
+  uint64_t F;
+};
+
+// Numero de valores guardados em um bool3S_64
+const int NUM_BITS_BOOL3S_64 = 64;
+
+// Os operadores logicos para a classe bool3S_64
+// Aplicam bit a bit as mesmas tabelas dos operadores de bool3S
+// Sao constexpr (como os de bool3S) para poderem ser usados em tempo de compilacao
+// (circuitoconst.h)
+
+// NOT 3S: troca os planos
+inline constexpr bool3S_64 operator~(bool3S_64 x)
+{
+  return bool3S_64{x.F, x.T};
+}
+// AND 3S: TRUE se os dois sao TRUE; FALSE se algum eh FALSE
+inline constexpr bool3S_64 operator&(bool3S_64 x1, bool3S_64 x2)
+{
+  return bool3S_64{x1.T & x2.T, x1.F | x2.F};
+}
+inline void operator&=(bool3S_64& x1, bool3S_64 x2)
+{
+  x1.T &= x2.T;
+  x1.F |= x2.F;
+}
+// OR 3S: TRUE se algum eh TRUE; FALSE se os dois sao FALSE
+inline constexpr bool3S_64 operator|(bool3S_64 x1, bool3S_64 x2)
+{
+  return bool3S_64{x1.T | x2.T, x1.F & x2.F};
+}
+inline void operator|=(bool3S_64& x1, bool3S_64 x2)
+{
+  x1.T |= x2.T;
+  x1.F &= x2.F;
+}
+// XOR 3S: soh eh definido se os dois sao definidos
+inline constexpr bool3S_64 operator^(bool3S_64 x1, bool3S_64 x2)
+{
+  return bool3S_64{(x1.T & x2.F) | (x1.F & x2.T), (x1.T & x2.T) | (x1.F & x2.F)};
+}
+inline void operator^=(bool3S_64& x1, bool3S_64 x2)
+{
+  x1 = x1 ^ x2;
+}
+
+// Comparacao (todos os 64 valores iguais)
+inline constexpr bool operator==(bool3S_64 x1, bool3S_64 x2)
+{
+  return x1.T==x2.T && x1.F==x2.F;
+}
+inline constexpr bool operator!=(bool3S_64 x1, bool3S_64 x2)
+{
+  return !(x1==x2);
+}
+
+// As conversoes entre bool3S_64 e bool3S
+
+// Retorna um bool3S_64 com os 64 valores iguais a B
+inline constexpr bool3S_64 toBool3S_64(bool3S B)
+{
+  return bool3S_64{B==bool3S::TRUE ? ~uint64_t(0) : 0, B==bool3S::FALSE ? ~uint64_t(0) : 0};
+}
+
+// Retorna o k-esimo valor (k de 0 a 63) guardado em X
+inline bool3S getBool3S(const bool3S_64& X, int k)
+{
+  if ((X.T >> k) & 1) return bool3S::TRUE;
+  if ((X.F >> k) & 1) return bool3S::FALSE;
+  return bool3S::UNDEF;
+}
+
+// Fixa o k-esimo valor (k de 0 a 63) guardado em X como sendo B
+inline void setBool3S(bool3S_64& X, int k, bool3S B)
+{
+  uint64_t bit = uint64_t(1) << k;
+  X.T &= ~bit;
+  X.F &= ~bit;
+  if (B==bool3S::TRUE) X.T |= bit;
+  if (B==bool3S::FALSE) X.F |= bit;
+}
+
+#endif // _BOOL3S_64_H_
@@ -0,0 +1,316 @@
+#include <cstring>
+#include "bytecode.h"
+
+//Autores:  Luisa de Moura Galvão Mathias
+//          Marcos Paulo Barbosa
+
+// O interpretador eh compilado tambem com AVX2 e AVX-512, usando o atributo target
+// apenas nessas funcoes (o resto do programa continua rodando em qualquer processador),
+// e a versao usada eh escolhida pelo processador
+// Nas versoes AVX2 e AVX-512, os planos sao calculados com os tipos __m256i e __m512i
+// (nao dependem da vetorizacao automatica, e por isso valem tambem sem otimizacao). As
+// operacoes sao os operadores &, | e ^ desses tipos, e nao funcoes como _mm256_and_si256,
+// porque o corpo do interpretador eh um template comum aas tres versoes, e essas funcoes
+// soh podem ser chamadas de funcoes com o atributo target
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define BYTECODE_X86
+#include <immintrin.h>
+#define SEMPRE_INLINE inline __attribute__((always_inline))
+#else
+#define SEMPRE_INLINE inline
+#endif
+
+const int W = PALAVRAS_BLOCO;
+
+///
+/// TRADUCAO
+///
+
+namespace {
+
+// Um operando de uma porta: a posicao do bloco do sinal e se ele deve ser negado
+struct Operando {
+  uint32_t pos;
+  bool negado;
+};
+
+// A operacao basica de uma porta
+enum class Base { E, OU, XOU };
+
+}
+
+// Acrescenta a Prog a instrucao que calcula dest = op(a, b), negada se negada for true,
+// com os operandos a e/ou b negados. As negacoes dos operandos sao eliminadas com
+// ~a^b = ~(a^b) e ~a&~b = ~(a|b) (e vice-versa); se sobrar uma, vira EN ou OUN
+static void emitirBinaria(std::vector<InstrucaoBytecode>& Prog, uint32_t dest, Base op,
+                          bool negada, Operando a, Operando b)
+{
+  if (op==Base::XOU)
+  {
+    bool neg = (negada != a.negado) != b.negado;
+    Prog.push_back(InstrucaoBytecode{neg ? OpBytecode::NXOU : OpBytecode::XOU, dest, a.pos, b.pos});
+    return;
+  }
+  if (a.negado && b.negado)
+  {
+    op = (op==Base::E ? Base::OU : Base::E);
+    negada = !negada;
+    a.negado = b.negado = false;
+  }
+  if (a.negado) std::swap(a, b);
+
+  OpBytecode codigo;
+  if (!b.negado)
+  {
+    if (op==Base::E) codigo = (negada ? OpBytecode::NE : OpBytecode::E);
+    else codigo = (negada ? OpBytecode::NOU : OpBytecode::OU);
+  }
+  else if (!negada) codigo = (op==Base::E ? OpBytecode::EN : OpBytecode::OUN);
+  else
+  {
+    // ~(a&~b) = b|~a e ~(a|~b) = b&~a
+    codigo = (op==Base::E ? OpBytecode::OUN : OpBytecode::EN);
+    std::swap(a, b);
+  }
+  Prog.push_back(InstrucaoBytecode{codigo, dest, a.pos, b.pos});
+}
+
+void ProgramaBytecode::montar(const NetlistPlana& P, const std::vector<int>& Bloco,
+                              const std::vector<bool>& Ciclo)
+{
+  const int NS = P.getNumSinais();
+  const int NP = P.getNumPorts();
+  const int NB = Ciclo.size();
+  const uint32_t TEMP = uint32_t(NS)*TAMANHO_BLOCO;
+
+  instrucoes.clear();
+  instrucoes.reserve(P.sinal_in.size() + NP);
+  tamanho = size_t(NS+1)*TAMANHO_BLOCO;
+
+  // Quantas vezes cada sinal eh lido (as saidas do circuito contam como leituras),
+  // a posicao da ultima porta que o leh e se cada porta estah em um bloco com realimentacao
+  std::vector<int> num_leituras(NS, 0), leitor(NS, -1);
+  std::vector<char> em_ciclo(NP, false);
+  for (int k=0; k<NP; k++)
+  {
+    for (int m=P.inicio_in[k]; m<P.inicio_in[k+1]; m++)
+    {
+      num_leituras[P.sinal_in[m]]++;
+      leitor[P.sinal_in[m]] = k;
+    }
+  }
+  for (unsigned j=0; j<P.sinal_out.size(); j++) num_leituras[P.sinal_out[j]]++;
+  for (int b=0; b<NB; b++)
+  {
+    if (Ciclo[b]) for (int k=Bloco[b]; k<Bloco[b+1]; k++) em_ciclo[k] = true;
+  }
+
+  // origem[s] eh o sinal negado pela porta NT de sinal s, se ela for embutida no seu
+  // unico leitor, ou -1
+  std::vector<int> origem(NS, -1);
+  for (int k=0; k<NP; k++)
+  {
+    int s = P.sinal[k];
+    if (P.tipo[k]!=TipoPorta::NT || em_ciclo[k] || num_leituras[s]!=1 || leitor[s]<0) continue;
+    int L = leitor[s];
+    if (!em_ciclo[L] && P.tipo[L]!=TipoPorta::NT && P.inicio_in[L+1]-P.inicio_in[L]>=2)
+    {
+      origem[s] = P.sinal_in[P.inicio_in[k]];
+    }
+  }
+
+  // Acrescenta as instrucoes da porta na posicao k, com o resultado em dest
+  auto emitirPorta = [&](int k, uint32_t dest)
+  {
+    Base op = Base::E;
+    bool negada = false;
+    switch (P.tipo[k])
+    {
+    case TipoPorta::NT: negada = true; break;
+    case TipoPorta::AN: break;
+    case TipoPorta::NA: negada = true; break;
+    case TipoPorta::OR: op = Base::OU; break;
+    case TipoPorta::NO: op = Base::OU; negada = true; break;
+    case TipoPorta::XO: op = Base::XOU; break;
+    case TipoPorta::NX: op = Base::XOU; negada = true; break;
+    }
+    auto operando = [&](int m)
+    {
+      int s = P.sinal_in[m];
+      if (origem[s]>=0) return Operando{uint32_t(origem[s])*TAMANHO_BLOCO, true};
+      return Operando{uint32_t(s)*TAMANHO_BLOCO, false};
+    };
+
+    int primeira = P.inicio_in[k], N = P.inicio_in[k+1]-primeira;
+    Operando acum = operando(primeira);
+    if (N==1)
+    {
+      // NT (ou porta de uma entrada): a&a = a
+      emitirBinaria(instrucoes, dest, Base::E, negada, acum, acum);
+      return;
+    }
+    for (int m=1; m<N; m++)
+    {
+      emitirBinaria(instrucoes, dest, op, m==N-1 && negada, acum, operando(primeira+m));
+      acum = Operando{dest, false};
+    }
+  };
+
+  for (int b=0; b<NB; b++)
+  {
+    if (!Ciclo[b])
+    {
+      int k = Bloco[b];
+      if (origem[P.sinal[k]]<0) emitirPorta(k, uint32_t(P.sinal[k])*TAMANHO_BLOCO);
+      continue;
+    }
+    for (int k=Bloco[b]; k<Bloco[b+1]; k++)
+    {
+      instrucoes.push_back(InstrucaoBytecode{OpBytecode::ZERAR, uint32_t(P.sinal[k])*TAMANHO_BLOCO, 0, 0});
+    }
+    uint32_t inicio = instrucoes.size();
+    for (int k=Bloco[b]; k<Bloco[b+1]; k++)
+    {
+      emitirPorta(k, TEMP);
+      instrucoes.push_back(InstrucaoBytecode{OpBytecode::CONFIRMAR, uint32_t(P.sinal[k])*TAMANHO_BLOCO, TEMP, 0});
+    }
+    instrucoes.push_back(InstrucaoBytecode{OpBytecode::REPETIR, 0, inicio, 0});
+  }
+}
+
+void ProgramaBytecode::clear()
+{
+  instrucoes.clear();
+  instrucoes.shrink_to_fit();
+  tamanho = 0;
+}
+
+///
+/// EXECUCAO
+///
+
+// Calcula os planos T e F do resultado da operacao OP a partir dos planos de x e y
+// R eh o tipo que guarda um pedaco de um plano: uint64_t (uma palavra), __m256i
+// (4 palavras, um registrador AVX2) ou __m512i (8 palavras, um registrador AVX-512).
+// Os tres tem os operadores &, | e ^ bit a bit, que nos tipos vetoriais viram as
+// instrucoes vpand, vpor e vpxor
+template<OpBytecode OP, class R>
+static SEMPRE_INLINE void calcularPlanos(const R& xT, const R& xF, const R& yT, const R& yF, R& T, R& F)
+{
+  if constexpr (OP==OpBytecode::NAO)       { T = xF; F = xT; }
+  else if constexpr (OP==OpBytecode::E)    { T = xT & yT; F = xF | yF; }
+  else if constexpr (OP==OpBytecode::NE)   { F = xT & yT; T = xF | yF; }
+  else if constexpr (OP==OpBytecode::OU)   { T = xT | yT; F = xF & yF; }
+  else if constexpr (OP==OpBytecode::NOU)  { F = xT | yT; T = xF & yF; }
+  else if constexpr (OP==OpBytecode::XOU)  { T = (xT & yF) | (xF & yT); F = (xT & yT) | (xF & yF); }
+  else if constexpr (OP==OpBytecode::NXOU) { F = (xT & yF) | (xF & yT); T = (xT & yT) | (xF & yF); }
+  else if constexpr (OP==OpBytecode::EN)   { T = xT & yF; F = xF | yT; }
+  else                                     { T = xT | yF; F = xF & yT; } // OUN
+}
+
+// Calcula o bloco d a partir dos blocos x e y aplicando a operacao OP aos planos T e F,
+// um R de cada vez. O resultado eh montado em uma variavel local e copiado no final,
+// porque d pode ser o proprio x ou y (nas cadeias das portas de varias entradas)
+// As copias com memcpy nao exigem alinhamento e viram simples leituras e escritas
+template<OpBytecode OP, class R>
+static SEMPRE_INLINE void aplicar(uint64_t* d, const uint64_t* x, const uint64_t* y)
+{
+  // Numero de palavras em um R
+  constexpr int N = sizeof(R)/sizeof(uint64_t);
+  static_assert(W%N==0, "um plano deve ter um numero inteiro de registradores");
+  R r[2*W/N];
+  for (int k=0; k<W; k+=N)
+  {
+    R xT, xF, yT, yF;
+    std::memcpy(&xT, x+k, sizeof(R));
+    std::memcpy(&xF, x+W+k, sizeof(R));
+    std::memcpy(&yT, y+k, sizeof(R));
+    std::memcpy(&yF, y+W+k, sizeof(R));
+    calcularPlanos<OP>(xT, xF, yT, yF, r[k/N], r[(W+k)/N]);
+  }
+  std::memcpy(d, r, sizeof(r));
+}
+
+template<class R>
+static SEMPRE_INLINE void executarPrograma(const InstrucaoBytecode* inicio,
+                                           const InstrucaoBytecode* fim, uint64_t* valores)
+{
+  bool mudou = false;
+  for (const InstrucaoBytecode* I=inicio; I!=fim; ++I)
+  {
+    uint64_t* d = valores + I->dest;
+    const uint64_t* x = valores + I->a;
+    const uint64_t* y = valores + I->b;
+    switch (I->op)
+    {
+    case OpBytecode::NAO:  aplicar<OpBytecode::NAO, R>(d, x, x); break;
+    case OpBytecode::E:    aplicar<OpBytecode::E, R>(d, x, y); break;
+    case OpBytecode::NE:   aplicar<OpBytecode::NE, R>(d, x, y); break;
+    case OpBytecode::OU:   aplicar<OpBytecode::OU, R>(d, x, y); break;
+    case OpBytecode::NOU:  aplicar<OpBytecode::NOU, R>(d, x, y); break;
+    case OpBytecode::XOU:  aplicar<OpBytecode::XOU, R>(d, x, y); break;
+    case OpBytecode::NXOU: aplicar<OpBytecode::NXOU, R>(d, x, y); break;
+    case OpBytecode::EN:   aplicar<OpBytecode::EN, R>(d, x, y); break;
+    case OpBytecode::OUN:  aplicar<OpBytecode::OUN, R>(d, x, y); break;
+    case OpBytecode::ZERAR:
+      std::memset(d, 0, TAMANHO_BLOCO*sizeof(uint64_t));
+      break;
+    case OpBytecode::CONFIRMAR:
+      if (std::memcmp(d, x, TAMANHO_BLOCO*sizeof(uint64_t))!=0)
+      {
+        std::memcpy(d, x, TAMANHO_BLOCO*sizeof(uint64_t));
+        mudou = true;
+      }
+      break;
+    case OpBytecode::REPETIR:
+      if (mudou)
+      {
+        mudou = false;
+        // A instrucao a eh a proxima a ser executada
+        I = inicio + I->a - 1;
+      }
+      break;
+    }
+  }
+}
+
+typedef void (*Interpretador)(const InstrucaoBytecode*, const InstrucaoBytecode*, uint64_t*);
+
+static void executarEscalar(const InstrucaoBytecode* inicio, const InstrucaoBytecode* fim,
+                            uint64_t* valores)
+{
+  executarPrograma<uint64_t>(inicio, fim, valores);
+}
+
+#ifdef BYTECODE_X86
+
+__attribute__((target("avx2")))
+static void executarAVX2(const InstrucaoBytecode* inicio, const InstrucaoBytecode* fim,
+                         uint64_t* valores)
+{
+  executarPrograma<__m256i>(inicio, fim, valores);
+}
+
+__attribute__((target("avx512f")))
+static void executarAVX512(const InstrucaoBytecode* inicio, const InstrucaoBytecode* fim,
+                           uint64_t* valores)
+{
+  executarPrograma<__m512i>(inicio, fim, valores);
+}
+
+#endif // BYTECODE_X86
+
+void ProgramaBytecode::executar(uint64_t* valores) const
+{
+  // O processador eh testado uma unica vez (variavel estatica local)
+  static const Interpretador interpretador = []()
+  {
+#ifdef BYTECODE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return executarAVX512;
+    if (__builtin_cpu_supports("avx2")) return executarAVX2;
+#endif
+    return executarEscalar;
+  }();
+  interpretador(instrucoes.data(), instrucoes.data()+instrucoes.size(), valores);
+}
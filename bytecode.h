@@ -0,0 +1,93 @@
+#ifndef _BYTECODE_H_
+#define _BYTECODE_H_
+
+//Autores:  Luisa de Moura Galvão Mathias
+//          Marcos Paulo Barbosa
+
+#include <cstdint>
+#include <vector>
+#include "netlist.h"
+
+///
+/// PROGRAMA EM BYTECODE
+///
+
+// O circuito traduzido para uma sequencia de instrucoes simples, executada por um
+// interpretador com um unico laco e um switch (sem chamadas de funcao por porta). Eh o
+// meio termo entre a simulacao porta a porta e a compilacao para codigo nativo
+// (CircuitoCompilado): a traducao eh uma unica passada sobre plana, e por isso pode
+// ser refeita a cada alteracao do circuito
+// Cada instrucao tem dois operandos e um destino, que sao posicoes na area de valores
+// no formato de ContextoSimulacao::val_bloco (um bloco de TAMANHO_BLOCO palavras por
+// sinal, mais um bloco temporario no final), e calcula o bloco inteiro de uma vez
+// - as portas de duas entradas viram uma unica instrucao;
+// - as de mais entradas viram uma cadeia de instrucoes que acumulam no destino, e a
+//   negacao (NA, NO, NX) fica na ultima instrucao da cadeia;
+// - uma porta NT cuja saida soh eh lida por uma porta de duas ou mais entradas fora
+//   de um bloco com realimentacao (e nao eh saida do circuito) nao vira instrucao: a
+//   negacao eh embutida na porta que a leh, com as instrucoes EN e OUN ou trocando a
+//   operacao (leis de De Morgan, ~a^b = ~(a^b))
+// - um bloco com realimentacao comeca com as suas portas em UNDEF (ZERAR); cada porta
+//   eh calculada no bloco temporario e copiada para o seu destino (CONFIRMAR), e o
+//   bloco eh repetido (REPETIR) ateh nenhum valor mudar, como em Circuito::simularLote
+
+// Um bloco guarda os valores de um sinal para 64*PALAVRAS_BLOCO combinacoes de entrada,
+// na mesma representacao em dois planos do bool3S_64:
+// - palavras 0 a PALAVRAS_BLOCO-1: plano T (bit em 1 se o valor eh TRUE)
+// - palavras PALAVRAS_BLOCO a 2*PALAVRAS_BLOCO-1: plano F (bit em 1 se o valor eh FALSE)
+// Com 8 palavras, cada plano de um bloco ocupa exatamente um registrador AVX-512
+// (512 combinacoes por instrucao) ou dois registradores AVX2 (256 por instrucao)
+
+// Numero de palavras de 64 bits em cada plano de um bloco
+const int PALAVRAS_BLOCO = 8;
+// Numero de palavras de 64 bits de um bloco inteiro (os dois planos)
+const int TAMANHO_BLOCO = 2*PALAVRAS_BLOCO;
+
+// As operacoes (a e b sao os operandos; ~, &, | e ^ sao os operadores 3S)
+enum class OpBytecode : uint8_t {
+  NAO,       // dest = ~a
+  E,         // dest = a & b
+  NE,        // dest = ~(a & b)
+  OU,        // dest = a | b
+  NOU,       // dest = ~(a | b)
+  XOU,       // dest = a ^ b
+  NXOU,      // dest = ~(a ^ b)
+  EN,        // dest = a & ~b
+  OUN,       // dest = a | ~b
+  ZERAR,     // dest = UNDEF
+  CONFIRMAR, // dest = temporario; anota se dest mudou
+  REPETIR    // se algum CONFIRMAR mudou o seu destino, desanota e volta para a instrucao a
+};
+
+struct InstrucaoBytecode {
+  OpBytecode op;
+  // Posicoes (em palavras) do destino e dos operandos na area de valores
+  uint32_t dest, a, b;
+};
+
+class ProgramaBytecode {
+private:
+  std::vector<InstrucaoBytecode> instrucoes;
+  // Numero de palavras da area de valores usada pelo programa
+  size_t tamanho;
+
+public:
+  ProgramaBytecode(): instrucoes(), tamanho(0) {}
+
+  // Traduz as portas de P, simuladas nos blocos Bloco e Ciclo (como Circuito::bloco_sim
+  // e Circuito::ciclo_sim)
+  void montar(const NetlistPlana& P, const std::vector<int>& Bloco, const std::vector<bool>& Ciclo);
+  // Esvazia o programa
+  void clear();
+
+  // Executa o programa: valores deve ter getTamanhoValores() palavras, com os blocos
+  // das entradas do circuito jah preenchidos
+  // Pode ser chamada ao mesmo tempo por varias threads (com areas de valores diferentes)
+  void executar(uint64_t* valores) const;
+
+  int getNumInstrucoes() const { return instrucoes.size(); }
+  const std::vector<InstrucaoBytecode>& getInstrucoes() const { return instrucoes; }
+  size_t getTamanhoValores() const { return tamanho; }
+};
+
+#endif // _BYTECODE_H_
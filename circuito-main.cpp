@@ -1,6 +1,11 @@
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include "circuito.h"
+#include "circuitoconst.h" // o compilador confere o circuito de exemplo (static_assert)
+#include "exportar.h"
+#include "tabela.h"
 
 //Autores:  Luisa de Moura Galvão Mathias
 //          Marcos Paulo Barbosa
@@ -8,9 +13,16 @@
 using namespace std;
 
 void gerarTabela(Circuito& C);
+void gerarTabelaOrdemGray(Circuito& C);
+void gerarTabelaOrdemArvore(Circuito& C);
+void gerarTabelaCubos(Circuito& C);
+int exportarSemMenu(int argc, char* argv[]);
 
-int main(void)
+int main(int argc, char* argv[])
 {
+  // Com argumentos, exporta a tabela verdade sem mostrar o menu
+  if (argc>1) return exportarSemMenu(argc, argv);
+
   Circuito C;
   string nome;
   int opcao;
@@ -24,30 +36,41 @@ int main(void)
       cout << "3 - Ler um circuito de arquivo\n";
       cout << "4 - Imprimir o circuito na tela\n";
       cout << "5 - Simular o circuito para todas as entrada (gerar tabela verdade)\n";
+      cout << "6 - Gerar tabela verdade em ordem Gray (uma entrada muda por linha)\n";
+      cout << "7 - Salvar um circuito em arquivo binario\n";
+      cout << "8 - Ler um circuito de arquivo binario\n";
+      cout << "9 - Otimizar o circuito (remover portas desnecessarias)\n";
+      cout << "10 - Remover as portas repetidas do circuito\n";
+      cout << "11 - Gerar tabela verdade em arvore (sem simular as linhas jah definidas)\n";
+      cout << "12 - Gerar tabela verdade em cubos ('-' em qualquer entrada que nao muda as saidas)\n";
+      cout << "13 - Compilar o circuito para codigo nativo (simulacao mais rapida)\n";
       cout << "Qual sua opcao? ";
       cin >> opcao;
-    } while(opcao<0 || opcao>5);
+    } while(opcao<0 || opcao>13);
     switch(opcao){
     case 1:
       C.digitar();
       break;
     case 2:
     case 3:
+    case 7:
+    case 8:
       // Antes de ler a string com o nome do arquivo, esvaziar o buffer do teclado
       cin.ignore(256,'\n');
       do {
         cout << "Arquivo: ";
         getline(cin,nome);
       } while (nome.size() < 3); // Name do arquivo >= 3 caracteres
-      if (opcao==3) {
-        if (!C.ler(nome))
+      if (opcao==3 || opcao==8) {
+        if (!(opcao==3 ? C.ler(nome) : C.lerBinario(nome)))
         {
           // Erro na leitura
           cerr << "Arquivo " << nome << " invalido para leitura\n";
+          cerr << C.getErroLeitura() << endl;
         }
       }
       else {
-        if (!C.salvar(nome))
+        if (!(opcao==2 ? C.salvar(nome) : C.salvarBinario(nome)))
         {
           // Erro no salvamento
           cerr << "Arquivo " << nome << " invalido para escrita\n";
@@ -60,6 +83,34 @@ int main(void)
     case 5:
       gerarTabela(C);
       break;
+    case 6:
+      gerarTabelaOrdemGray(C);
+      break;
+    case 9:
+      {
+        int NP = C.getNumPorts();
+        if (C.otimizar()) cout << "Portas: " << NP << " -> " << C.getNumPorts() << endl;
+        else cerr << "Circuito invalido para otimizacao\n";
+      }
+      break;
+    case 10:
+      {
+        int NP = C.getNumPorts();
+        int removidas = C.removerPortasRepetidas();
+        if (removidas>=0) cout << "Portas repetidas removidas: " << removidas << " de " << NP << endl;
+        else cerr << "Circuito invalido para otimizacao\n";
+      }
+      break;
+    case 11:
+      gerarTabelaOrdemArvore(C);
+      break;
+    case 12:
+      gerarTabelaCubos(C);
+      break;
+    case 13:
+      if (C.compilar()) cout << "Circuito compilado\n";
+      else cerr << "Erro na compilacao: " << C.getErroCompilacao() << endl;
+      break;
     default:
       break;
     }
@@ -68,52 +119,157 @@ int main(void)
 
 void gerarTabela(Circuito& C)
 {
-  vector<bool3S> in_circ(C.getNumInputs());
+  // As linhas sao simuladas em paralelo e escritas na ordem, trecho a trecho, atraves
+  // de um buffer grande (em vez de um cout para cada valor)
+  cout << flush;
+  bool tabela_OK = exportarTabela(C, "-", FormatoTabela::TEXTO, 0,
+                                  numLinhasTabela(C.getNumInputs()));
+
+  if (!tabela_OK) cerr << "Circuito invalido para simulacao\n";
+}
+
+// Imprime uma linha da tabela verdade: as entradas, separadas das saidas por tabulacao
+void imprimirLinha(const Circuito& C, const vector<bool3S>& in_circ, const vector<bool3S>& out_circ)
+{
   int i;
 
-  // Comeca com todas as entradas indefinidas
+  // Impressao das entradas
   for (i=0; i<C.getNumInputs(); i++)
   {
-    in_circ.at(i) = bool3S::UNDEF;
+    cout << in_circ[i];
+    if (i<C.getNumInputs()-1) cout << ' ';
+    else
+    {
+      cout <<'\t';
+      if (C.getNumInputs()<=2) cout <<'\t';
+    }
+  }
+
+  // Impressao das saidas
+  for (i=0; i<C.getNumOutputs(); i++)
+  {
+    cout << out_circ[i];
+    if (i<C.getNumOutputs()-1) cout << ' ';
+    else cout << '\n';
   }
+}
+
+void gerarTabelaCubos(Circuito& C)
+{
+  // Cada linha impressa eh um cubo: um conjunto de linhas da tabela com as mesmas saidas
+  // (as entradas com '-' podem ter qualquer valor, e os cubos nao seguem a ordem das linhas)
+  cout << flush;
+  bool tabela_OK = exportarTabela(C, "-", FormatoTabela::CUBOS, 0,
+                                  numLinhasTabela(C.getNumInputs()));
 
+  if (!tabela_OK) cerr << "Circuito invalido para simulacao\n";
+}
+
+void gerarTabelaOrdemGray(Circuito& C)
+{
   cout << "ENTRADAS" << '\t' << "SAIDAS" << endl;
-  do
+
+  // Cada linha eh simulada de forma incremental a partir da anterior
+  bool tabela_OK = gerarTabelaGray(C, OrdemTabela::GRAY,
+                                   [&C](uint64_t, const vector<bool3S>& in_circ,
+                                        const vector<bool3S>& out_circ)
   {
-    // Simulacao
-    C.simular(in_circ);
+    imprimirLinha(C, in_circ, out_circ);
+  });
 
-    // Impressao das entradas
-    for (i=0; i<C.getNumInputs(); i++)
+  if (!tabela_OK) cerr << "Circuito invalido para simulacao\n";
+}
+
+void gerarTabelaOrdemArvore(Circuito& C)
+{
+  uint64_t simuladas;
+
+  cout << "ENTRADAS" << '\t' << "SAIDAS" << endl;
+
+  // As linhas cujas saidas jah sao definidas por uma linha com entradas UNDEF nao
+  // sao simuladas
+  bool tabela_OK = gerarTabelaArvore(C, [&C](uint64_t, const vector<bool3S>& in_circ,
+                                             const vector<bool3S>& out_circ)
+  {
+    imprimirLinha(C, in_circ, out_circ);
+  }, &simuladas);
+
+  if (!tabela_OK) cerr << "Circuito invalido para simulacao\n";
+  else cout << "Linhas simuladas: " << simuladas << " de " << numLinhasTabela(C.getNumInputs()) << endl;
+}
+
+// Exporta a tabela verdade de acordo com os argumentos da linha de comando:
+// circuito ARQUIVO [--binario] [--formato texto|csv|binario|cubos] [--inicio N] [--fim N]
+//                  [--saida ARQ] [--threads N] [--compilar]
+// ARQUIVO eh lido com Circuito::ler ou, com --binario, com Circuito::lerBinario
+// Com --compilar, o circuito eh compilado para codigo nativo antes de gerar a tabela
+// (se a compilacao falhar, a tabela eh gerada do mesmo jeito, sem codigo nativo)
+// Sem --saida (ou com --saida -), a tabela vai para a saida padrao
+// Retorna o codigo de saida do programa (0 se deu tudo OK)
+int exportarSemMenu(int argc, char* argv[])
+{
+  const char* uso = "Uso: circuito ARQUIVO [--binario] [--formato texto|csv|binario|cubos]"
+                    " [--inicio N] [--fim N] [--saida ARQ] [--threads N] [--compilar]\n";
+  string arq = argv[1], saida = "-";
+  FormatoTabela formato = FormatoTabela::TEXTO;
+  bool binario = false, tem_fim = false, compilar = false;
+  uint64_t inicio = 0, fim = 0;
+  int Nthreads = 0;
+
+  for (int a=2; a<argc; a++)
+  {
+    string opcao = argv[a];
+    if (opcao=="--binario")
     {
-      cout << in_circ.at(i);
-      if (i<C.getNumInputs()-1) cout << ' ';
-      else
-      {
-        cout <<'\t';
-        if (C.getNumInputs()<=2) cout <<'\t';
-      }
+      binario = true;
+      continue;
     }
-
-    // Impressao das saidas
-    for (i=0; i<C.getNumOutputs(); i++)
+    if (opcao=="--compilar")
     {
-      cout << C.getOutput(i+1);
-      if (i<C.getNumOutputs()-1) cout << ' ';
-      else cout << '\n';
+      compilar = true;
+      continue;
     }
-
-    // Determina qual entrada deve ser incrementada na proxima linha
-    // Incrementa a ultima possivel que nao for TRUE
-    // Se a ultima for TRUE, faz essa ser UNDEF e tenta incrementar a anterior
-    i = C.getNumInputs()-1;
-    while (i>=0 && in_circ.at(i)==bool3S::TRUE)
+    if (a+1>=argc)
     {
-      in_circ.at(i)++;
-      i--;
-    };
-    // Incrementa a input selecionada
-    if (i>=0) in_circ.at(i)++;
-  } while (i>=0);
-}
+      cerr << uso;
+      return 2;
+    }
+    string valor = argv[++a];
+    if (opcao=="--formato" && valor=="texto") formato = FormatoTabela::TEXTO;
+    else if (opcao=="--formato" && valor=="csv") formato = FormatoTabela::CSV;
+    else if (opcao=="--formato" && valor=="binario") formato = FormatoTabela::BINARIO;
+    else if (opcao=="--formato" && valor=="cubos") formato = FormatoTabela::CUBOS;
+    else if (opcao=="--inicio") inicio = strtoull(valor.c_str(), nullptr, 10);
+    else if (opcao=="--fim")
+    {
+      fim = strtoull(valor.c_str(), nullptr, 10);
+      tem_fim = true;
+    }
+    else if (opcao=="--saida") saida = valor;
+    else if (opcao=="--threads") Nthreads = atoi(valor.c_str());
+    else
+    {
+      cerr << uso;
+      return 2;
+    }
+  }
 
+  Circuito C;
+  if (!(binario ? C.lerBinario(arq) : C.ler(arq)))
+  {
+    cerr << "Arquivo " << arq << " invalido para leitura\n";
+    cerr << C.getErroLeitura() << endl;
+    return 1;
+  }
+  if (compilar && !C.compilar())
+  {
+    cerr << "Erro na compilacao: " << C.getErroCompilacao() << endl;
+  }
+  if (!tem_fim) fim = numLinhasTabela(C.getNumInputs());
+  if (!exportarTabela(C, saida, formato, inicio, fim, Nthreads))
+  {
+    cerr << "Erro ao exportar a tabela verdade (circuito, intervalo de linhas ou arquivo invalido)\n";
+    return 1;
+  }
+  return 0;
+}
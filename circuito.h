@@ -4,10 +4,20 @@
 //Autores:  Luisa de Moura Galvão Mathias
 //          Marcos Paulo Barbosa
 
+#include <atomic>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <string>
 #include <vector>
+#include "arquivo.h"
 #include "bool3S.h"
+#include "bool3S_64.h"
+#include "bytecode.h"
+#include "contexto.h"
+#include "netlist.h"
 #include "port.h"
 
 /// ###########################################################################
@@ -26,7 +36,18 @@
 /// CLASSE CIRCUIT
 ///
 
+class CircuitoCompilado;
+
 class Circuito {
+  // O gerador de codigo nativo leh a ordem de simulacao (plana e os blocos)
+  friend class CircuitoCompilado;
+
+public:
+  // Cone de entrada (fan-in) de um conjunto de saidas do circuito: as portas das quais
+  // as saidas dependem, direta ou indiretamente (prepararSaidas e simularSaidas). Eh
+  // definido em circuito_incompleto.cpp
+  struct ConeSaidas;
+
 private:
   /// ***********************
   /// Dados
@@ -50,6 +71,135 @@ private:
   // As portas
   std::vector<ptr_Port> ports;  // vetor a ser alocado com dimensao "Nports"
 
+  // A arena de onde vem a memoria de todas as portas do circuito (os objetos e os vetores
+  // de entradas), criadas com criarPorta e destruidas com destruirPorta
+  // A arena reserva de uma soh vez a memoria para todas as portas (o tamanho eh estimado
+  // pelo numero de portas em resize e na copia), e toda a memoria eh devolvida de uma vez
+  // por clear. A memoria de uma porta substituida (setPort) soh eh devolvida no clear
+  // Eh um ponteiro para que o circuito possa ser movido sem copiar as portas
+  std::unique_ptr<std::pmr::monotonic_buffer_resource> arena;
+
+  // Descarta a arena atual (as portas jah devem ter sido destruidas) e cria uma nova,
+  // com espaco inicial para NP portas
+  void novaArena(int NP);
+
+  // Os valores dos sinais usados pelos metodos de simulacao que nao recebem um
+  // ContextoSimulacao como parametro (simular, simular64 e simularLote nao const)
+  // As portas nao guardam os valores da simulacao: o Circuito soh eh alterado por
+  // esses metodos atraves deste contexto e do vetor out_circ
+  ContextoSimulacao contexto;
+
+  // A descricao do erro da ultima leitura de arquivo (ler), ou "" se deu certo
+  std::string erro_leitura;
+
+  // O circuito compilado para codigo nativo (compilar), ou nullptr. Soh eh usado pela
+  // simulacao enquanto a sua versao for igual a versao_sim (o circuito nao mudou)
+  std::shared_ptr<const CircuitoCompilado> compilado;
+  // A descricao do erro da ultima compilacao, ou "" se deu certo
+  std::string erro_compilacao;
+
+  /// ***********************
+  /// Ordem de simulacao (calculada uma vez e guardada)
+  /// ***********************
+
+  // Os dados da ordem de simulacao sao "mutable" porque sao calculados, quando
+  // necessario, pelos metodos const de simulacao. O calculo eh protegido por trava_ordem,
+  // de modo que varias threads podem comecar a simular o mesmo circuito ao mesmo tempo
+
+  // As portas na representacao compacta usada pelos metodos de simulacao, na ordem em
+  // que devem ser simuladas
+  // As portas sao agrupadas em blocos (componentes fortemente conexas do grafo de
+  // ligacoes), e os blocos estao em ordem topologica: todas as portas das quais um bloco
+  // depende aparecem em blocos anteriores. Os blocos estao ordenados por nivel (maior
+  // distancia ateh as entradas do circuito) e, dentro de cada nivel, pelo tipo da porta
+  mutable NetlistPlana plana;
+  // O arquivo binario mapeado em memoria para o qual plana aponta, quando o circuito
+  // foi lido com lerBinario (nullptr caso contrario). Eh mantido ateh o proximo clear
+  std::unique_ptr<ArquivoMapeado> arquivo_netlist;
+  // Posicao em plana do inicio de cada bloco; o ultimo elemento eh o numero de portas
+  mutable std::vector<int> bloco_sim;
+  // ciclo_sim[b] eh true se o bloco b tem realimentacao (mais de uma porta ou uma porta
+  // ligada a si mesma), e por isso precisa ser simulado ateh estabilizar
+  mutable std::vector<bool> ciclo_sim;
+  // As sequencias de simulacao: trechos de plana que sao simulados de uma vez. A
+  // sequencia q comeca na posicao inicio_seq[q] (o ultimo elemento eh o numero de
+  // portas) e eh um bloco com realimentacao (ciclo_seq[q] true) ou um conjunto de
+  // blocos consecutivos sem realimentacao com portas do mesmo tipo, simulados com um
+  // laco especializado para esse tipo (NetlistPlana::simularSequencia)
+  mutable std::vector<int> inicio_seq;
+  mutable std::vector<bool> ciclo_seq;
+  // true se plana, bloco_sim e ciclo_sim correspondem aas ligacoes atuais do circuito
+  mutable std::atomic<bool> ordem_ok;
+  // Trava usada para calcular a ordem uma unica vez quando varias threads simulam
+  mutable std::mutex trava_ordem;
+  // true se o circuito era valido (valid) quando a ordem foi calculada
+  mutable bool valido_sim;
+
+  // Indice de leitores (fan-out) usado pela simulacao incremental, calculado junto
+  // com a ordem: os blocos das portas que leem o sinal s (indiceSinal) sao
+  // leitores[inicio_leitores[s]] a leitores[inicio_leitores[s+1]-1]
+  mutable std::vector<int> inicio_leitores;
+  mutable std::vector<int> leitores;
+
+  // A ordem de simulacao traduzida para bytecode, usada por simularLote. Eh montada
+  // junto com as sequencias, de modo que eh refeita sempre que o circuito muda
+  mutable ProgramaBytecode bytecode;
+
+  // Os cones jah calculados (prepararSaidas), indexados pelas ids das saidas em ordem
+  // crescente. Sao descartados quando a ordem de simulacao eh recalculada, e no maximo
+  // MAX_CONES_GUARDADOS ficam guardados: quando falta espaco, sai o usado ha mais tempo
+  // (uso eh o valor de uso_cones na ultima consulta)
+  static const size_t MAX_CONES_GUARDADOS = 64;
+  struct ConeGuardado {
+    std::shared_ptr<const ConeSaidas> cone;
+    unsigned long uso;
+  };
+  mutable std::map<std::vector<int>, ConeGuardado> cones;
+  mutable unsigned long uso_cones;
+  // Trava para que varias threads possam consultar e incluir cones ao mesmo tempo
+  mutable std::mutex trava_cones;
+
+  // Retorna o cone das saidas IdOutputs (ids validas, em ordem crescente e sem
+  // repeticoes), calculando e guardando o cone se ainda nao estiver guardado
+  std::shared_ptr<const ConeSaidas> coneSaidas(const std::vector<int>& IdOutputs) const;
+
+  // Identifica as ligacoes atuais do circuito: muda (para um valor nunca usado antes,
+  // em nenhum circuito) sempre que a ordem eh invalidada. Um ContextoSimulacao guarda
+  // a versao com que foi simulado, para saber se o seu estado ainda serve para a
+  // simulacao incremental
+  unsigned long versao_sim;
+
+  // Descarta a ordem de simulacao e muda a versao do circuito
+  // Deve ser chamada sempre que mudar alguma porta ou ligacao do circuito
+  void invalidarOrdem();
+
+  // Calcula a ordem de simulacao (algoritmo de Tarjan para componentes fortemente conexas)
+  // e monta plana e o indice de leitores
+  // Soh eh chamada por prepararSimulacao, com trava_ordem travada
+  void calcularOrdem() const;
+
+  // Monta as sequencias de simulacao (inicio_seq e ciclo_seq), o indice de leitores e o
+  // bytecode a partir de plana, bloco_sim e ciclo_sim
+  // Eh chamada por calcularOrdem e por lerBinario, que jah recebe os blocos prontos
+  void montarSequencias() const;
+
+  // Simula um bloco com realimentacao (posicoes inicio a fim-1 de plana): as portas
+  // do bloco comecam indefinidas e sao resimuladas ateh estabilizar
+  void simularCiclo(int inicio, int fim, ContextoSimulacao& Ctx) const;
+
+  // Substitui o circuito pelo circuito montado a partir de plana por otimizar (com
+  // simplificar true) ou por removerPortasRepetidas (simplificar false)
+  // Deve ser chamada com a ordem de simulacao calculada (prepararSimulacao)
+  // Retorna o numero de portas repetidas encontradas
+  int reconstruir(bool simplificar);
+
+  // Calcula Ctx.out_circ a partir dos valores dos sinais em Ctx.val_sinal
+  void calcularSaidas(ContextoSimulacao& Ctx) const;
+
+  // Retorna o indice do sinal cuja id eh IdOrig: as entradas do circuito sao os sinais
+  // 0 a Nin-1, seguidas pelas portas
+  int indiceSinal(int IdOrig) const;
+
 public:
 
   /// ***********************
@@ -64,32 +214,30 @@ public:
   // Construtor por copia
   // Nin e os vetores id_out e out_circ serao copias dos equivalentes no Circuit C
   // O vetor ports terah a mesma dimensao do equivalente no Circuit C
-  // Serah necessario utilizar a funcao virtual clone para criar copias das portas
+  // As portas sao copiadas com a funcao virtual clone para a arena deste circuito
   Circuito(const Circuito& C);
   // Construtor por movimento
-  // Nin e os vetores id_out, out_circ e ports assumirao o conteudo dos equivalentes
-  // no Circuit temporario C, que serah zerado
+  // Nin e os vetores id_out, out_circ e ports (e a arena com as portas) assumirao o
+  // conteudo dos equivalentes no Circuit temporario C, que serah zerado
   Circuito(Circuito&& C);
 
   // Destrutor: apenas chama a funcao clear()
   ~Circuito();
   // Limpa todo o conteudo do circuito. Faz Nin <- 0 e
   // utiliza o metodo STL clear para limpar os vetores id_out, out_circ e ports
-  // ATENCAO: antes de dar um clear no vetor ports, tem que liberar (delete) as areas
-  // de memoria para as quais cada ponteiro desse vetor aponta.
+  // Antes de dar um clear no vetor ports, destroi as portas (destruirPorta) e depois
+  // devolve toda a memoria da arena de uma vez
   void clear();
 
   // Operador de atribuicao por copia
   // Atribui (faz copia) de Nin e dos vetores id_out e out_circ
-  // ATENCAO: antes de alterar o vetor ports, tem que liberar (delete) as areas
-  // de memoria para as quais cada ponteiro desse vetor aponta.
+  // Antes de alterar o vetor ports, limpa o circuito (clear)
   // O vetor ports terah a mesma dimensao do equivalente no Circuit C
-  // Serah necessario utilizar a funcao virtual clone para criar copias das portas
+  // As portas sao copiadas com a funcao virtual clone para a arena deste circuito
   void operator=(const Circuito& C);
   // Operador de atribuicao por movimento
-  // Move Nin e os vetores id_out, out_circ e ports
-  // ATENCAO: antes de mover o vetor ports, tem que liberar (delete) as areas
-  // de memoria anteriores para as quais cada ponteiro desse vetor aponta.
+  // Move Nin e os vetores id_out, out_circ e ports, junto com a arena das portas
+  // Antes de mover, limpa o circuito (clear)
   void operator=(Circuito&& C);
 
   // Redimensiona o circuito para passar a ter NI entradas, NO saidas e NP ports
@@ -159,6 +307,11 @@ public:
   // ou bool3S::UNDEF se parametro invalido
   bool3S getOutput(int IdOutput) const;
 
+  // Retorna os valores logicos da saida cuja id eh IdOutput calculados pela
+  // ultima chamada de simular64 (um valor para cada combinacao de entrada)
+  // ou tudo bool3S::UNDEF se parametro invalido ou se ainda nao houve simulacao
+  bool3S_64 getOutput64(int IdOutput) const;
+
   // Caracteristicas das portas
 
   // Retorna o nome da porta: AN, NX, etc
@@ -194,15 +347,47 @@ public:
 
   // A porta cuja id eh IdPort passa a ser do tipo Tipo (NT, AN, etc.), com NIn entradas
   // Depois de varios testes (Id, tipo, num de entradas), faz:
-  // 1) Libera a antiga area de memoria: delete ports[IdPort-1]
-  // 2) Cria a nova porta: ports[IdPort-1] <- new ... (de acordo com tipo)
+  // 1) Destroi a antiga porta: destruirPorta(ports[IdPort-1])
+  // 2) Cria a nova porta na arena: ports[IdPort-1] <- allocPort(...) (de acordo com tipo)
   // 3) Fixa o numero de entrada: ports[IdPort-1]->setNumInputs(NIn)
   void setPort(int IdPort, std::string Tipo, int NIn);
 
   // Altera a origem da I-esima entrada da porta cuja id eh IdPort, que passa a ser "IdOrig"
   // Depois de VARIOS testes (definedPort, validIndex, validIdOrig)
   // faz: ports[IdPort-1]->setId_in(I,Idorig)
-  void setId_inPort(int IdPort, int I, int IdOrig) const;
+  void setId_inPort(int IdPort, int I, int IdOrig);
+
+  /// ***********************
+  /// Otimizacao
+  /// ***********************
+
+  // Substitui o circuito por um circuito equivalente (as mesmas saidas para qualquer
+  // entrada, inclusive bool3S::UNDEF) com menos portas:
+  // - remove as portas das quais nenhuma saida depende;
+  // - propaga as constantes: com portas de bool3S, a unica constante possivel eh UNDEF
+  //   (um bloco com realimentacao cujas entradas de fora do bloco sao todas constantes,
+  //   ou nenhuma). Um NOT, XOR ou NXOR com alguma entrada constante eh constante, assim
+  //   como um AND, NAND, OR ou NOR com todas as entradas constantes;
+  // - desfaz NOT de NOT, ligando os leitores ao sinal original;
+  // - remove as entradas repetidas de AND, NAND, OR e NOR. Se sobrar uma soh entrada, o
+  //   AND (OR) eh substituido pela propria entrada e o NAND (NOR) por um NOT;
+  // - substitui as portas repetidas (removerPortasRepetidas)
+  // As portas dos blocos com realimentacao sao mantidas (soh as entradas sao religadas)
+  // As portas restantes sao renumeradas, na ordem das ids originais; se alguma porta ou
+  // saida ler uma constante, eh criada uma porta NOT ligada a si mesma (sempre UNDEF)
+  // Retorna false (sem alterar o circuito) se o circuito for invalido
+  bool otimizar();
+
+  // Encontra as portas iguais (mesmo tipo e mesmas origens das entradas, em qualquer
+  // ordem) por uma tabela hash e mantem apenas uma delas: as entradas de portas e as
+  // saidas do circuito que liam as demais passam a ler essa. Como as portas sao
+  // examinadas na ordem de simulacao, as que ficam iguais depois da substituicao das
+  // suas entradas tambem sao encontradas. As portas dos blocos com realimentacao nao
+  // sao comparadas
+  // As demais portas sao mantidas, com novas ids na mesma ordem das ids originais
+  // Retorna o numero de portas removidas, ou -1 (sem alterar o circuito) se o circuito
+  // for invalido
+  int removerPortasRepetidas();
 
   /// ***********************
   /// E/S de dados
@@ -212,7 +397,7 @@ public:
   // O usuario digita o numero de entradas, saidas e portas
   // apos o que, se os valores estiverem corretos (>0), redimensiona o circuito
   // Em seguida, para cada porta o usuario digita o tipo (NT,AN,NA,OR,NO,XO,NX) que eh conferido
-  // Apos criada dinamicamente (new) a porta do tipo correto, chama a
+  // Apos criada dinamicamente (allocPort, na arena) a porta do tipo correto, chama a
   // funcao digitar na porta recem-criada. A porta digitada eh conferida (validPort).
   // Em seguida, o usuario digita as ids de todas as saidas, que sao conferidas (validIdOrig).
   // Se o usuario digitar um dado invalido, o metodo deve pedir que ele digite novamente
@@ -220,16 +405,20 @@ public:
   void digitar();
 
   // Entrada dos dados de um circuito via arquivo
+  // O arquivo eh mapeado em memoria (ArquivoMapeado) e lido diretamente, sem copias
   // Leh do arquivo o cabecalho com o numero de entradas, saidas e portas
-  // Em seguida, para cada porta leh e confere a id e o tipo (validType)
-  // Apos criada dinamicamente (allocPort) a porta do tipo correto, chama a
-  // funcao ler na porta recem-criada. O retorno da leitura da porta eh conferido
-  // bem como se a porta lida eh valida (validPort) para o circuito.
+  // Em seguida, para cada porta leh e confere a id, o tipo (validType), o numero de
+  // entradas (validNumInputs) e as ids das entradas (validIdOrig), criando a porta do
+  // tipo correto na arena (allocPort)
   // Em seguida, leh as ids de todas as saidas, que sao conferidas (validIdOrig)
-  // Retorna true se deu tudo OK; false se deu erro.
-  // Deve utilizar o metodo ler da classe Port
+  // Retorna true se deu tudo OK; false se deu erro. Em caso de erro, o circuito fica
+  // vazio e a descricao do erro, com linha e coluna, pode ser consultada com getErroLeitura
   bool ler(const std::string& arq);
 
+  // Retorna a descricao do erro da ultima chamada de ler (por exemplo,
+  // "linha 4, coluna 9: id de origem invalido: 7"), ou "" se a leitura deu certo
+  const std::string& getErroLeitura() const;
+
   // Saida dos dados de um circuito (em tela ou arquivo, a mesma funcao serve para os dois)
   // Imprime os cabecalhos e os dados do circuito, caso o circuito seja valido
   // Deve utilizar os metodos de impressao da classe Port
@@ -240,6 +429,20 @@ public:
   // Retorna true se deu tudo OK; false se deu erro
   bool salvar(const std::string& arq) const;
 
+  // Salva o circuito no formato binario (ver lerNetlistBinaria), caso seja valido
+  // O arquivo guarda a representacao compacta usada pela simulacao (NetlistPlana) e a
+  // ordem de simulacao jah calculada
+  // Retorna true se deu tudo OK; false se deu erro
+  bool salvarBinario(const std::string& arq) const;
+
+  // Entrada dos dados de um circuito via arquivo no formato binario (salvarBinario)
+  // O arquivo eh mapeado em memoria e a simulacao usa diretamente o seu conteudo, sem
+  // conversao e sem recalcular a ordem de simulacao; as portas (Port) sao criadas a
+  // partir dele. Varios processos que leem o mesmo arquivo compartilham a memoria
+  // Retorna true se deu tudo OK; false se deu erro. Em caso de erro, o circuito fica
+  // vazio e a descricao do erro pode ser consultada com getErroLeitura
+  bool lerBinario(const std::string& arq);
+
   /// ***********************
   /// SIMULACAO (funcao principal do circuito)
   /// ***********************
@@ -249,11 +452,119 @@ public:
   // validos (caso contrario retorna false)
   // A entrada eh um vetor de bool3S, com dimensao igual ao numero de entradas
   // do circuito.
+  // As portas sao simuladas na ordem calculada por calcularOrdem: cada porta fora
+  // de um ciclo eh simulada uma unica vez; soh os blocos com realimentacao sao
+  // simulados repetidamente ateh que nenhuma porta do bloco mude de valor
   // Depois de simular todas as portas do circuito, calcula as saidas do
   // circuito (out_circ <- ...)
-  // Retorna true se a simulacao foi OK; false caso deh erro
+  // Retorna true se todas as portas ficaram com valor definido; false se alguma porta
+  // ficou bool3S::UNDEF (as saidas sao calculadas mesmo assim) ou se o circuito ou a
+  // dimensao da entrada forem invalidos
   bool simular(const std::vector<bool3S>& in_circ);
 
+  // Igual ao simular anterior, mas guardando os valores das portas e das saidas
+  // no contexto Ctx em vez de alterar o circuito (as saidas podem ser consultadas com
+  // Ctx.getOutput). Pode ser chamada ao mesmo tempo por varias threads, cada uma com
+  // o seu proprio contexto
+  bool simular(const std::vector<bool3S>& in_circ, ContextoSimulacao& Ctx) const;
+
+  // Simulacao incremental (dirigida por eventos): calcula o mesmo que simular, mas
+  // aproveita os valores das portas da simulacao anterior guardados no contexto
+  // Soh sao resimuladas as portas que leem uma entrada do circuito que mudou desde a
+  // simulacao anterior e, em seguida, apenas as portas que leem alguma porta cuja saida
+  // mudou, na ordem dos blocos de simulacao. Eh vantajosa quando entradas consecutivas
+  // diferem em poucos valores (por exemplo, ao percorrer a tabela verdade)
+  // Se o contexto nao tiver estado anterior deste circuito (ou se o circuito tiver sido
+  // alterado depois), faz uma simulacao completa
+  bool simularIncremental(const std::vector<bool3S>& in_circ);
+  bool simularIncremental(const std::vector<bool3S>& in_circ, ContextoSimulacao& Ctx) const;
+
+  // Calcula o cone das saidas de ids IdOutputs (em qualquer ordem, podendo repetir), a
+  // partir das ligacoes atuais, para simular apenas essas saidas com simularSaidas
+  // Quem simula as mesmas saidas muitas vezes deve guardar o cone retornado: ele
+  // continua valendo, sem nenhuma consulta ao circuito, ateh o circuito ser alterado
+  // Retorna nullptr se o circuito ou alguma id de saida for invalida
+  std::shared_ptr<const ConeSaidas> prepararSaidas(const std::vector<int>& IdOutputs) const;
+
+  // Simula apenas as portas do cone Cone (prepararSaidas), em vez de todas as portas do
+  // circuito, com o contexto Ctx. Nao usa travas nem aloca memoria (depois da primeira
+  // simulacao com Ctx), de modo que pode ser chamada por varias threads ao mesmo tempo
+  // Soh as saidas do cone sao calculadas (Ctx.getOutput); as demais ficam bool3S::UNDEF,
+  // e os valores das portas fora do cone (Ctx.getOutputPort) nao devem ser usados
+  // Retorna false se a dimensao da entrada for invalida, Cone for nullptr ou o circuito
+  // tiver sido alterado depois de prepararSaidas
+  bool simularSaidas(const std::vector<bool3S>& in_circ, const std::shared_ptr<const ConeSaidas>& Cone,
+                     ContextoSimulacao& Ctx) const;
+
+  // Igual ao anterior, para as saidas de ids IdOutputs: o cone de cada conjunto de saidas
+  // eh calculado na primeira simulacao e guardado para as seguintes (ateh o circuito ser
+  // alterado ou sair do cache de cones)
+  // Retorna false se o circuito, a dimensao da entrada ou alguma id de saida for invalida
+  bool simularSaidas(const std::vector<bool3S>& in_circ, const std::vector<int>& IdOutputs);
+  bool simularSaidas(const std::vector<bool3S>& in_circ, const std::vector<int>& IdOutputs,
+                     ContextoSimulacao& Ctx) const;
+
+  // Simula o circuito para 64 combinacoes de entrada de uma soh vez
+  // A entrada eh um vetor de bool3S_64, com dimensao igual ao numero de entradas
+  // do circuito: o k-esimo bit de cada elemento forma a k-esima combinacao de entrada
+  // Segue a mesma ordem de simulacao do metodo simular, e o k-esimo bit das saidas
+  // eh igual ao que simular calcularia para a k-esima combinacao
+  // As saidas podem ser consultadas com getOutput64
+  // Retorna true se a simulacao foi OK; false caso deh erro
+  bool simular64(const std::vector<bool3S_64>& in_circ);
+
+  // Igual ao simular64 anterior, guardando os valores no contexto Ctx
+  // (as saidas podem ser consultadas com Ctx.getOutput64)
+  bool simular64(const std::vector<bool3S_64>& in_circ, ContextoSimulacao& Ctx) const;
+
+  // Simula o circuito para 64*NPalavras combinacoes de entrada
+  // in_circ tem dimensao Nin*NPalavras: in_circ[i*NPalavras+w] guarda as combinacoes
+  // 64*w a 64*w+63 da entrada do circuito cuja id eh -(i+1)
+  // out_lote eh redimensionado para Nout*NPalavras e recebe as saidas no mesmo formato:
+  // out_lote[j*NPalavras+w] para a saida cuja id eh j+1
+  // As portas sao simuladas em blocos de 64*PALAVRAS_BLOCO combinacoes pelo programa
+  // em bytecode do circuito (ProgramaBytecode)
+  // O resultado eh o mesmo de simular64 aplicado a cada elemento
+  // Retorna true se a simulacao foi OK; false caso deh erro
+  bool simularLote(const std::vector<bool3S_64>& in_circ, int NPalavras,
+                   std::vector<bool3S_64>& out_lote);
+
+  // Igual ao simularLote anterior, guardando os valores dos sinais no contexto Ctx
+  bool simularLote(const std::vector<bool3S_64>& in_circ, int NPalavras,
+                   std::vector<bool3S_64>& out_lote, ContextoSimulacao& Ctx) const;
+
+  // Compila o circuito para codigo nativo (CircuitoCompilado), usando o diretorio de
+  // cache dir_cache ("" para o padrao, diretorioCacheCompilados): gera uma funcao C++
+  // com um comando por porta, compila-a com o compilador do sistema (ou reaproveita a
+  // biblioteca jah compilada para o mesmo circuito) e a carrega
+  // Depois disso, simular64 e simularLote passam a chamar a funcao compilada, com os
+  // mesmos resultados, ateh o circuito ser alterado (quando voltam a simular as portas)
+  // Retorna true se deu tudo OK; false se o circuito for invalido ou a compilacao
+  // falhar (a simulacao continua sem codigo nativo, e o erro pode ser consultado com
+  // getErroCompilacao)
+  // ATENCAO: o circuito nao pode ser compilado enquanto houver simulacoes em andamento
+  bool compilar(const std::string& dir_cache = "");
+
+  // Retorna true se a simulacao estah usando o codigo nativo (compilar) do circuito atual
+  bool usaCodigoCompilado() const;
+
+  // Retorna a descricao do erro da ultima chamada de compilar, ou "" se deu certo
+  const std::string& getErroCompilacao() const;
+
+  // Calcula a ordem de simulacao, caso ainda nao esteja calculada
+  // Eh chamada automaticamente pelos metodos de simulacao; pode ser chamada antes
+  // para que o calculo nao seja feito durante a primeira simulacao
+  // ATENCAO: o circuito nao pode ser alterado enquanto houver simulacoes em andamento
+  // Retorna true se o circuito eh valido e pode ser simulado
+  bool prepararSimulacao() const;
+
+  // Dimensiona todos os vetores do contexto Ctx para este circuito, de modo que as
+  // simulacoes seguintes com Ctx (simular, simularIncremental, simular64 e simularLote)
+  // nao facam nenhuma alocacao de memoria. Sem essa chamada, a memoria eh alocada na
+  // primeira simulacao de cada tipo e reaproveitada nas seguintes
+  // Retorna false se o circuito for invalido
+  bool prepararContexto(ContextoSimulacao& Ctx) const;
+
 };
 
 // Operador de impressao da classe Circuit
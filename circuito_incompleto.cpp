@@ -1,6 +1,12 @@
+#include <algorithm>
+#include <climits>
 #include <fstream>
+#include <functional> // para std::greater
+#include <new> // para std::bad_alloc
+#include <unordered_map>
 #include <utility> // para std::swap
 #include "circuito.h"
+#include "compilado.h"
 
 //Autores:  Luisa de Moura Galvão Mathias
 //          Marcos Paulo Barbosa
@@ -21,26 +27,51 @@ bool validType(std::string& Tipo)
     return false;
 }
 
-// Funcao auxiliar que retorna um ponteiro que aponta para uma porta alocada dinamicamente
+// Funcao auxiliar que retorna um ponteiro que aponta para uma porta alocada na arena Mem
+// (criarPorta), que deve ser destruida com destruirPorta
 // O tipo da porta alocada depende do parametro string de entrada (AN, OR, etc.)
 // Caso o tipo nao seja nenhum dos validos, retorna nullptr
 // Pode ser utilizada nas funcoes: Circuito::setPort, Circuito::digitar e Circuito::ler
-ptr_Port allocPort(std::string& Tipo)
+ptr_Port allocPort(std::string& Tipo, std::pmr::memory_resource* Mem)
 {
     if (!validType(Tipo)) return nullptr;
 
-    if (Tipo=="NT") return new Port_NOT;
-    if (Tipo=="AN") return new Port_AND;
-    if (Tipo=="NA") return new Port_NAND;
-    if (Tipo=="OR") return new Port_OR;
-    if (Tipo=="NO") return new Port_NOR;
-    if (Tipo=="XO") return new Port_XOR;
-    if (Tipo=="NX") return new Port_NXOR;
+    if (Tipo=="NT") return criarPorta<Port_NOT>(Mem);
+    if (Tipo=="AN") return criarPorta<Port_AND>(Mem);
+    if (Tipo=="NA") return criarPorta<Port_NAND>(Mem);
+    if (Tipo=="OR") return criarPorta<Port_OR>(Mem);
+    if (Tipo=="NO") return criarPorta<Port_NOR>(Mem);
+    if (Tipo=="XO") return criarPorta<Port_XOR>(Mem);
+    if (Tipo=="NX") return criarPorta<Port_NXOR>(Mem);
 
     // Nunca deve chegar aqui...
     return nullptr;
 }
 
+// Igual ao anterior, com o tipo dado por um TipoPorta (usada por Circuito::lerBinario)
+ptr_Port allocPort(TipoPorta Tipo, std::pmr::memory_resource* Mem)
+{
+    switch (Tipo)
+    {
+    case TipoPorta::NT: return criarPorta<Port_NOT>(Mem);
+    case TipoPorta::AN: return criarPorta<Port_AND>(Mem);
+    case TipoPorta::NA: return criarPorta<Port_NAND>(Mem);
+    case TipoPorta::OR: return criarPorta<Port_OR>(Mem);
+    case TipoPorta::NO: return criarPorta<Port_NOR>(Mem);
+    case TipoPorta::XO: return criarPorta<Port_XOR>(Mem);
+    case TipoPorta::NX: return criarPorta<Port_NXOR>(Mem);
+    }
+    return nullptr;
+}
+
+// Funcao auxiliar que retorna uma versao de circuito (Circuito::versao_sim) nunca
+// retornada antes. Comeca em 1: a versao 0 indica um contexto sem estado
+static unsigned long novaVersao()
+{
+    static std::atomic<unsigned long> ultima(0);
+    return ++ultima;
+}
+
 ///
 /// CLASSE CIRCUITO
 ///
@@ -48,93 +79,94 @@ ptr_Port allocPort(std::string& Tipo)
 /// ***********************
 /// Inicializacao e finalizacao
 /// ***********************
-Circuito::Circuito(): Nin(0), id_out(), out_circ(), ports(){} //construtor default
-
-Circuito::Circuito(const Circuito& C):Nin(C.Nin){ //construtor por copia
-    id_out.resize(C.id_out.size());
-    out_circ.resize(C.out_circ.size());
-
-    for(unsigned i=0; i<C.id_out.size(); i++){
-        id_out.at(i) = C.id_out.at(i);
-        out_circ.at(i) = C.out_circ.at(i);
-    }
-
+Circuito::Circuito(): Nin(0), id_out(), out_circ(), ports(), arena(), contexto(), erro_leitura(),
+    compilado(), erro_compilacao(),
+    plana(), arquivo_netlist(), bloco_sim(), ciclo_sim(), inicio_seq(), ciclo_seq(), ordem_ok(false), trava_ordem(), valido_sim(false),
+    inicio_leitores(), leitores(), bytecode(), uso_cones(0), versao_sim(novaVersao()){
+    novaArena(0);
+} //construtor default
+
+Circuito::Circuito(const Circuito& C):Nin(C.Nin), id_out(C.id_out), out_circ(C.out_circ),
+    ordem_ok(false), valido_sim(false), uso_cones(0), versao_sim(novaVersao()){ //construtor por copia
+    novaArena(C.getNumPorts());
+    ports.reserve(C.ports.size());
     for(unsigned i=0; i<C.ports.size(); i++){
-        ports.push_back(ports.at(i)->clone());
+        ports.push_back(C.ports.at(i) != nullptr ? C.ports.at(i)->clone(arena.get()) : nullptr);
     }
 }
 
-Circuito::Circuito(Circuito&& C):Nin(C.Nin){ //construtor por movimento
-    this->clear();
-    id_out.resize(C.id_out.size());
-    out_circ.resize(C.out_circ.size());
-
-    for(unsigned i=0; i<C.id_out.size(); i++){
-        id_out.at(i) = C.id_out.at(i);
-        out_circ.at(i) = C.out_circ.at(i);
-    }
-
-    for(unsigned i=0; i<C.ports.size(); i++){
-        ports.push_back(ports.at(i)->clone());
-    }
-
+Circuito::Circuito(Circuito&& C):Nin(C.Nin), id_out(std::move(C.id_out)), out_circ(std::move(C.out_circ)),
+    ports(std::move(C.ports)), arena(std::move(C.arena)),
+    ordem_ok(false), valido_sim(false), uso_cones(0), versao_sim(novaVersao()){ //construtor por movimento
+    // As portas continuam na mesma arena, que agora pertence a este circuito
+    C.ports.clear();
+    C.novaArena(0);
     C.clear();
 }
 Circuito::~Circuito(){ clear(); } //destrutor
 
 // Limpa todo o conteudo do circuito. Faz Nin <- 0 e
 // utiliza o metodo STL clear para limpar os vetores id_out, out_circ e ports
-// ATENCAO: antes de dar um clear no vetor ports, tem que liberar (delete) as areas
-// de memoria para as quais cada ponteiro desse vetor aponta.
+// Antes de dar um clear no vetor ports, destroi as portas, e depois devolve de uma
+// vez toda a memoria da arena
 void Circuito::clear(){
     Nin = 0;
     id_out.clear();
     out_circ.clear();
+    contexto.clear();
 
-    for(unsigned i = 0; i < ports.size(); i++) delete ports.at(i);
+    for(unsigned i = 0; i < ports.size(); i++) destruirPorta(ports.at(i));
     ports.clear();
+    arena->release();
+
+    invalidarOrdem();
+    // plana pode apontar para o arquivo binario
+    plana.clear();
+    bytecode.clear();
+    arquivo_netlist.reset();
+    compilado.reset();
+}
+
+// Descarta a arena atual e cria uma nova, com espaco inicial para NP portas
+// (uma porta de 2 entradas com o seu vetor de entradas)
+void Circuito::novaArena(int NP){
+    const size_t TAMANHO_PORTA = sizeof(Port_AND) + 2*sizeof(int) + alignof(std::max_align_t);
+    arena.reset(new std::pmr::monotonic_buffer_resource(std::max(NP, 1)*TAMANHO_PORTA));
 }
 
 // Operador de atribuicao por copia
 // Atribui (faz copia) de Nin e dos vetores id_out e out_circ
-// ATENCAO: antes de alterar o vetor ports, tem que liberar (delete) as areas
-// de memoria para as quais cada ponteiro desse vetor aponta.
+// Antes de alterar o vetor ports, limpa o circuito (clear)
 // O vetor ports terah a mesma dimensao do equivalente no Circuit C
-// Serah necessario utilizar a funcao virtual clone para criar copias das portas
+// As portas sao copiadas com a funcao virtual clone para a arena deste circuito
 void Circuito::operator=(const Circuito& C){
-    clear();
+    if(this == &C) return;
+    clear(); // clear tambem invalida a ordem de simulacao
+    novaArena(C.getNumPorts());
     Nin = C.Nin;
-    id_out.resize(C.id_out.size());
-    out_circ.resize(C.out_circ.size());
-
-    for(unsigned i=0; i<C.id_out.size(); i++){
-        id_out.at(i) = C.id_out.at(i);
-        out_circ.at(i) = C.out_circ.at(i);
-    }
+    id_out = C.id_out;
+    out_circ = C.out_circ;
 
+    ports.reserve(C.ports.size());
     for(unsigned i=0; i<C.ports.size(); i++){
-        ports.push_back(ports.at(i)->clone());
+        ports.push_back(C.ports.at(i) != nullptr ? C.ports.at(i)->clone(arena.get()) : nullptr);
     }
 }
 
 // Operador de atribuicao por movimento
-// Move Nin e os vetores id_out, out_circ e ports
-// ATENCAO: antes de mover o vetor ports, tem que liberar (delete) as areas
-// de memoria anteriores para as quais cada ponteiro desse vetor aponta.
+// Move Nin e os vetores id_out, out_circ e ports, junto com a arena das portas
+// Antes de mover, limpa o circuito (clear)
 void Circuito::operator=(Circuito&& C){
+    if(this == &C) return;
+    clear(); // clear tambem invalida a ordem de simulacao
     Nin = C.Nin;
-    id_out.resize(C.id_out.size());
-    out_circ.resize(C.out_circ.size());
-
-    for(unsigned i=0; i<C.id_out.size(); i++){
-        id_out.at(i) = C.id_out.at(i);
-        out_circ.at(i) = C.out_circ.at(i);
-    }
-
-    for(unsigned i=0; i<C.ports.size(); i++){
-        ports.push_back(ports.at(i)->clone());
-    }
+    id_out = std::move(C.id_out);
+    out_circ = std::move(C.out_circ);
+    ports = std::move(C.ports);
+    std::swap(arena, C.arena);
 
+    // C fica com a arena vazia deste circuito
+    C.ports.clear();
     C.clear();
 }
 
@@ -148,6 +180,7 @@ void Circuito::operator=(Circuito&& C){
 void Circuito::resize(int NI, int NO, int NP){
     if(NI>0 && NO>0 && NP>0){
         clear();
+        novaArena(NP);
         Nin = NI;
 
         id_out.resize(NO, 0);
@@ -265,6 +298,13 @@ bool3S Circuito::getOutput(int IdOutput) const{
     else return bool3S::UNDEF;
 }
 
+// Retorna os valores logicos da saida cuja id eh IdOutput calculados por simular64
+// ou tudo bool3S::UNDEF se parametro invalido
+bool3S_64 Circuito::getOutput64(int IdOutput) const{
+    if(validIdOutput(IdOutput)) return contexto.getOutput64(IdOutput);
+    else return toBool3S_64(bool3S::UNDEF);
+}
+
 // Retorna o nome da porta: AN, NX, etc
 // Depois de testar se a porta existe (definedPort),
 // retorna ports.at(IdPort-1)->getName()
@@ -317,22 +357,211 @@ void Circuito::setIdOutput(int IdOut, int IdOrig){
 // 3) Fixa o numero de entrada: ports[IdPort-1]->setNumInputs(NIn)
 void Circuito::setPort(int IdPort, std::string Tipo, int NIn){
     if(validIdPort(IdPort) && validType(Tipo)){ //&& ports[IdPort-1]->validNumInputs(NIn) testar isso tbm?
-        delete ports.at(IdPort-1);
+        destruirPorta(ports.at(IdPort-1));
 
-        ports.at(IdPort-1) = allocPort(Tipo);
+        ports.at(IdPort-1) = allocPort(Tipo, arena.get());
         ports.at(IdPort-1)->setNumInputs(NIn);
+        invalidarOrdem();
     }
 }
 
 // Altera a origem da I-esima entrada da porta cuja id eh IdPort, que passa a ser "IdOrig"
 // Depois de VARIOS testes (definedPort, validIndex, validIdOrig)
 // faz: ports[IdPort-1]->setId_in(I,Idorig)
-void Circuito::setId_inPort(int IdPort, int I, int IdOrig) const{
+void Circuito::setId_inPort(int IdPort, int I, int IdOrig){
     if(definedPort(IdPort) && ports.at(IdPort-1)->validIndex(I) && validIdOrig(IdOrig)){
         ports.at(IdPort-1)->setId_in(I, IdOrig);
+        invalidarOrdem();
     }
 }
 
+/// ***********************
+/// Otimizacao
+/// ***********************
+
+// Funcao de hash para as chaves das portas (tipo seguido das referencias das entradas)
+// usadas por Circuito::reconstruir para encontrar portas repetidas
+struct HashPorta {
+    size_t operator()(const std::vector<int>& chave) const{
+        size_t h = chave.size();
+        for(unsigned i=0; i<chave.size(); i++) h = h*1000003u ^ size_t(uint32_t(chave[i]));
+        return h;
+    }
+};
+
+// Monta o circuito percorrendo os blocos na ordem de simulacao (plana), de modo que as
+// entradas de cada porta jah estao montadas quando ela eh examinada
+// Cada sinal do circuito original passa a ser uma referencia: a id (negativa) de uma
+// entrada do circuito, 1 + o indice de uma porta do novo circuito (positiva) ou
+// CONST_UNDEF (0). Antes de criar uma porta sem realimentacao, procura em uma tabela hash
+// uma porta jah criada com o mesmo tipo e as mesmas entradas (em ordem crescente, pois
+// todas as portas de mais de uma entrada sao comutativas) e, se houver, usa essa porta
+// No final, as portas que nao alimentam nenhuma saida sao descartadas (se simplificar
+// for true) e as restantes recebem novas ids, na ordem das ids originais
+int Circuito::reconstruir(bool simplificar){
+    const int CONST_UNDEF = 0;
+    struct PortaNova {
+        TipoPorta tipo;
+        std::vector<int> in;
+        // A id da porta original que deu origem a esta
+        int id_origem;
+    };
+    std::vector<PortaNova> novas;
+    std::unordered_map<std::vector<int>, int, HashPorta> criadas;
+    std::vector<int> ref(plana.getNumSinais());
+    for(int i=0; i<Nin; i++) ref[i] = -(i+1);
+    int id_origem = 0;
+    int repetidas = 0;
+
+    // Retorna a referencia para a porta de tipo T com as entradas in, criando-a se nao
+    // houver outra igual
+    std::vector<int> chave;
+    auto criar = [&](TipoPorta T, const std::vector<int>& in){
+        chave.assign(1, int(T));
+        chave.insert(chave.end(), in.begin(), in.end());
+        std::sort(chave.begin()+1, chave.end());
+        auto it = criadas.find(chave);
+        if(it != criadas.end()){
+            repetidas++;
+            return it->second;
+        }
+        novas.push_back(PortaNova{T, in, id_origem});
+        criadas.insert(std::make_pair(chave, int(novas.size())));
+        return int(novas.size());
+    };
+    // Retorna a referencia para o NOT de x (desfazendo o NOT de NOT)
+    auto negar = [&](int x){
+        if(x == CONST_UNDEF) return CONST_UNDEF;
+        if(x > 0 && novas[x-1].tipo == TipoPorta::NT) return novas[x-1].in[0];
+        return criar(TipoPorta::NT, std::vector<int>(1, x));
+    };
+
+    std::vector<int> in;
+    int NB = ciclo_sim.size();
+    for(int b=0; b<NB; b++){
+        if(ciclo_sim[b]){
+            // As portas do bloco sao criadas antes, para que possam ler umas aas outras
+            int primeira = novas.size()+1, ultima = primeira + bloco_sim[b+1]-bloco_sim[b];
+            for(int k=bloco_sim[b]; k<bloco_sim[b+1]; k++) ref[plana.sinal[k]] = primeira + k-bloco_sim[b];
+            bool constante = simplificar;
+            for(int k=bloco_sim[b]; k<bloco_sim[b+1]; k++){
+                in.clear();
+                for(int m=plana.inicio_in[k]; m<plana.inicio_in[k+1]; m++){
+                    int x = ref[plana.sinal_in[m]];
+                    if(x != CONST_UNDEF && (x < primeira || x >= ultima)) constante = false;
+                    in.push_back(x);
+                }
+                novas.push_back(PortaNova{plana.tipo[k], in, plana.sinal[k]-Nin+1});
+            }
+            // Sem nenhuma entrada definida de fora, as portas do bloco nunca saem de UNDEF
+            if(constante){
+                novas.resize(primeira-1);
+                for(int k=bloco_sim[b]; k<bloco_sim[b+1]; k++) ref[plana.sinal[k]] = CONST_UNDEF;
+            }
+            continue;
+        }
+
+        int k = bloco_sim[b];
+        TipoPorta T = plana.tipo[k];
+        id_origem = plana.sinal[k]-Nin+1;
+        in.clear();
+        for(int m=plana.inicio_in[k]; m<plana.inicio_in[k+1]; m++) in.push_back(ref[plana.sinal_in[m]]);
+        int r;
+        if(!simplificar) r = criar(T, in);
+        else switch(T){
+        case TipoPorta::NT:
+            r = negar(in[0]);
+            break;
+        case TipoPorta::XO:
+        case TipoPorta::NX:
+            // UNDEF em qualquer entrada torna a saida UNDEF
+            if(std::find(in.begin(), in.end(), CONST_UNDEF) != in.end()) r = CONST_UNDEF;
+            else r = criar(T, in);
+            break;
+        default:
+            // AND, NAND, OR e NOR: x AND x == x (o mesmo para OR)
+            for(unsigned j=1; j<in.size(); j++){
+                if(std::find(in.begin(), in.begin()+j, in[j]) != in.begin()+j) in.erase(in.begin() + j--);
+            }
+            if(in.size() > 1) r = criar(T, in);
+            else if(T == TipoPorta::AN || T == TipoPorta::OR) r = in[0];
+            else r = negar(in[0]);
+            break;
+        }
+        ref[plana.sinal[k]] = r;
+    }
+
+    // Marca as portas das quais alguma saida depende (ou todas, se nao simplificar)
+    std::vector<int> saidas;
+    std::vector<char> usada(novas.size(), !simplificar);
+    std::vector<int> pilha;
+    bool usa_constante = false;
+    auto marcar = [&](int x){
+        if(x == CONST_UNDEF) usa_constante = true;
+        else if(x > 0 && !usada[x-1]){
+            usada[x-1] = true;
+            pilha.push_back(x-1);
+        }
+    };
+    for(int j=0; j<getNumOutputs(); j++){
+        saidas.push_back(ref[plana.sinal_out[j]]);
+        marcar(saidas.back());
+    }
+    while(!pilha.empty()){
+        int n = pilha.back();
+        pilha.pop_back();
+        for(unsigned m=0; m<novas[n].in.size(); m++) marcar(novas[n].in[m]);
+    }
+
+    // Novas ids, na ordem das ids das portas originais
+    // O circuito precisa ter ao menos uma porta: se nao sobrar nenhuma, fica a constante
+    std::vector<int> ordem;
+    for(unsigned n=0; n<novas.size(); n++){
+        if(usada[n]) ordem.push_back(n);
+    }
+    std::stable_sort(ordem.begin(), ordem.end(), [&novas](int n1, int n2){
+        return novas[n1].id_origem < novas[n2].id_origem;
+    });
+    std::vector<int> nova_id(novas.size(), 0);
+    int NP = 0;
+    for(unsigned n=0; n<ordem.size(); n++) nova_id[ordem[n]] = ++NP;
+    int id_constante = (usa_constante || NP == 0 ? ++NP : 0);
+    auto idRef = [&](int x){ return x < 0 ? x : (x == CONST_UNDEF ? id_constante : nova_id[x-1]); };
+
+    Circuito Novo;
+    Novo.resize(Nin, getNumOutputs(), NP);
+    for(unsigned n=0; n<novas.size(); n++){
+        if(!usada[n]) continue;
+        ptr_Port porta = allocPort(novas[n].tipo, Novo.arena.get());
+        porta->setNumInputs(novas[n].in.size());
+        for(unsigned m=0; m<novas[n].in.size(); m++) porta->setId_in(m, idRef(novas[n].in[m]));
+        Novo.ports.at(nova_id[n]-1) = porta;
+    }
+    if(id_constante > 0){
+        ptr_Port porta = allocPort(TipoPorta::NT, Novo.arena.get());
+        porta->setNumInputs(1);
+        porta->setId_in(0, id_constante);
+        Novo.ports.at(id_constante-1) = porta;
+    }
+    for(int j=0; j<getNumOutputs(); j++) Novo.id_out.at(j) = idRef(saidas[j]);
+
+    *this = std::move(Novo);
+    return repetidas;
+}
+
+// Otimiza o circuito (reconstruir com todas as simplificacoes)
+bool Circuito::otimizar(){
+    if(!prepararSimulacao()) return false;
+    reconstruir(true);
+    return true;
+}
+
+// Substitui as portas repetidas (reconstruir sem as demais simplificacoes)
+int Circuito::removerPortasRepetidas(){
+    if(!prepararSimulacao()) return -1;
+    return reconstruir(false);
+}
+
 /// ***********************
 /// E/S de dados
 /// ***********************
@@ -341,7 +570,7 @@ void Circuito::setId_inPort(int IdPort, int I, int IdOrig) const{
 // O usuario digita o numero de entradas, saidas e portas
 // apos o que, se os valores estiverem corretos (>0), redimensiona o circuito
 // Em seguida, para cada porta o usuario digita o tipo (NT,AN,NA,OR,NO,XO,NX) que eh conferido
-// Apos criada dinamicamente (new) a porta do tipo correto, chama a
+// Apos criada dinamicamente (allocPort, na arena) a porta do tipo correto, chama a
 // funcao digitar na porta recem-criada. A porta digitada eh conferida (validPort).
 // Em seguida, o usuario digita as ids de todas as saidas, que sao conferidas (validIdOrig).
 // Se o usuario digitar um dado invalido, o metodo deve pedir que ele digite novamente
@@ -376,8 +605,9 @@ void Circuito::digitar(){
             std::cout << "Digite o tipo da porta " << i+1<< ":";
             std::cin >> tipo;
         }
-        if(ports.at(i) != nullptr) delete ports.at(i);  ///lembrar de fazer  nos outros
-        ports.at(i) = allocPort(tipo);
+        destruirPorta(ports.at(i));
+        ports.at(i) = allocPort(tipo, arena.get());
+        invalidarOrdem();
         do{
             ports.at(i)->digitar();
         }while(!validPort(i+1));
@@ -398,65 +628,142 @@ void Circuito::digitar(){
 }
 
 // Entrada dos dados de um circuito via arquivo
-// Leh do arquivo o cabecalho com o numero de entradas, saidas e portas
-// Em seguida, para cada porta leh e confere a id e o tipo (validType)
-// Apos criada dinamicamente (allocPort) a porta do tipo correto, chama a
-// funcao ler na porta recem-criada. O retorno da leitura da porta eh conferido
-// bem como se a porta lida eh valida (validPort) para o circuito.
-// Em seguida, leh as ids de todas as saidas, que sao conferidas (validIdOrig)
-// Retorna true se deu tudo OK; false se deu erro.
-// Deve utilizar o metodo ler da classe Port
+// O arquivo eh mapeado em memoria e percorrido por um LeitorTexto, que converte os
+// numeros diretamente do texto e guarda a linha e coluna de cada erro
+// Cada erro eh lancado como ErroLeitura e tratado no final, limpando o circuito
 bool Circuito::ler(const std::string& arq){
-    std::ifstream arqv(arq.c_str());
+    ArquivoMapeado arqv;
 
+    erro_leitura.clear();
     try{
-        if (!arqv.is_open()) throw 1;
-
-        std::string prov, prov1;
-        unsigned in, out, portas;
-        unsigned idprov;
-        char test;
-
-        arqv >> prov >> in >> out >> portas >> prov1;
-
-        if (!arqv.good() || prov != "CIRCUITO" || in<=0 || out<=0 || portas<=0 || prov1 != "PORTAS") throw 2;
+        if (!arqv.abrir(arq)) throw ErroLeitura(0, 0, "nao foi possivel abrir o arquivo " + arq);
+        LeitorTexto L(arqv.dados(), arqv.dados()+arqv.tamanho());
+
+        L.palavra("CIRCUITO");
+        int in = L.inteiro("numero de entradas", 1, INT_MAX);
+        // Cada porta ocupa pelo menos 8 caracteres do arquivo ("1)NT 1:1") e cada saida
+        // pelo menos 3 ("1)1"), de modo que numeros maiores sao erros, e nao pedidos de
+        // alocacao enormes
+        LeitorTexto::Posicao pos = L.posicao();
+        int out = L.inteiro("numero de saidas", 1, INT_MAX);
+        if(size_t(out) > arqv.tamanho()/3) L.erro(pos, "numero de saidas maior que o arquivo");
+        pos = L.posicao();
+        int portas = L.inteiro("numero de portas", 1, INT_MAX);
+        if(size_t(portas) > arqv.tamanho()/8) L.erro(pos, "numero de portas maior que o arquivo");
+        L.palavra("PORTAS");
         resize(in,out,portas);
 
-        for(unsigned i=0 ; i<portas; i++){
-
-            std::string nomePorta;
-            arqv >> idprov >> test;
-
-            if(idprov != i+1 || test != ')') throw 3;
-
-            arqv >> nomePorta;
-
-            if(!validType(nomePorta)) throw 4;
-            ptr_Port portaProv  = allocPort(nomePorta);
-            if(!portaProv->ler(arqv)) throw 5;
-            ports.at(i) = portaProv;
+        for(int i=0 ; i<portas; i++){
+            pos = L.posicao();
+            if(L.inteiro("id da porta", 1, INT_MAX) != i+1){
+                L.erro(pos, "esperada a porta " + std::to_string(i+1));
+            }
+            L.caractere(')', "depois da id da porta");
+
+            const char* ini;
+            size_t n;
+            pos = L.posicao();
+            L.palavra(ini, n, "tipo da porta");
+            std::string nomePorta(ini, n);
+            if(!validType(nomePorta)) L.erro(pos, "tipo de porta invalido: " + std::string(ini, n));
+            ports.at(i) = allocPort(nomePorta, arena.get());
+
+            pos = L.posicao();
+            int NI = L.inteiro("numero de entradas da porta", 1, INT_MAX);
+            if(!ports.at(i)->validNumInputs(NI)){
+                L.erro(pos, "numero de entradas invalido para a porta " + nomePorta + ": " + std::to_string(NI));
+            }
+            ports.at(i)->setNumInputs(NI);
+            L.caractere(':', "depois do numero de entradas da porta");
+            for(int j=0; j<NI; j++){
+                pos = L.posicao();
+                int id = L.inteiro("id de origem", -in, portas);
+                if(id == 0) L.erro(pos, "id de origem invalido: 0");
+                ports.at(i)->setId_in(j, id);
+            }
         }
 
-        arqv >> prov;
-        if(prov != "SAIDAS") throw 6;
-        for(unsigned i=0 ; i<out; i++){
-            int saida;
-            arqv >> idprov >> test;
-            if(idprov != i+1 || test != ')') throw 7;
-            arqv >> saida;
-            id_out.at(i) = saida;
+        L.palavra("SAIDAS");
+        for(int i=0 ; i<out; i++){
+            pos = L.posicao();
+            if(L.inteiro("id da saida", 1, INT_MAX) != i+1){
+                L.erro(pos, "esperada a saida " + std::to_string(i+1));
+            }
+            L.caractere(')', "depois da id da saida");
+            pos = L.posicao();
+            int id = L.inteiro("id de origem da saida", -in, portas);
+            if(id == 0) L.erro(pos, "id de origem da saida invalido: 0");
+            id_out.at(i) = id;
         }
+        invalidarOrdem();
 
-        bool circ_valid = valid();
-        if(!circ_valid) throw 8;
+        if(!valid()) throw ErroLeitura(0, 0, "circuito invalido");
+    }
+    catch (const ErroLeitura& E)
+    {
+        clear();
+        erro_leitura = E.texto();
+        return false;
+    }
+    catch (const std::bad_alloc&)
+    {
+        clear();
+        erro_leitura = ErroLeitura(0, 0, "memoria insuficiente para o circuito").texto();
+        return false;
+    }
 
+    return true;
+}
+
+// Retorna a descricao do erro da ultima leitura
+const std::string& Circuito::getErroLeitura() const{
+    return erro_leitura;
+}
+
+// Entrada dos dados de um circuito via arquivo no formato binario
+// O conteudo do arquivo eh conferido por lerNetlistBinaria e passa a ser a representacao
+// compacta do circuito (plana). As portas sao criadas a partir dela: a porta na posicao
+// k de plana eh a de id sinal[k]-Nin+1
+bool Circuito::lerBinario(const std::string& arq){
+    std::unique_ptr<ArquivoMapeado> arqv(new ArquivoMapeado);
+    NetlistPlana P;
+    std::vector<int> bloco;
+    std::vector<bool> ciclo;
+
+    erro_leitura.clear();
+    try{
+        if (!arqv->abrir(arq)) throw ErroLeitura(0, 0, "nao foi possivel abrir o arquivo " + arq);
+        lerNetlistBinaria(arqv->dados(), arqv->tamanho(), P, bloco, ciclo);
     }
-    catch (int i)
+    catch (const ErroLeitura& E)
     {
         clear();
+        erro_leitura = E.texto();
         return false;
     }
 
+    // Converte o indice de um sinal na id correspondente
+    auto idSinal = [&P](int s){ return s < P.Nin ? -(s+1) : s-P.Nin+1; };
+
+    resize(P.Nin, P.sinal_out.size(), P.getNumPorts());
+    for(int k=0; k<P.getNumPorts(); k++){
+        int NI = P.inicio_in[k+1]-P.inicio_in[k];
+        ptr_Port porta = allocPort(P.tipo[k], arena.get());
+        porta->setNumInputs(NI);
+        for(int j=0; j<NI; j++) porta->setId_in(j, idSinal(P.sinal_in[P.inicio_in[k]+j]));
+        ports.at(idSinal(P.sinal[k])-1) = porta;
+    }
+    for(int j=0; j<getNumOutputs(); j++) id_out.at(j) = idSinal(P.sinal_out[j]);
+    invalidarOrdem();
+
+    // A ordem de simulacao jah vem pronta no arquivo
+    plana = P;
+    bloco_sim.swap(bloco);
+    ciclo_sim.swap(ciclo);
+    arquivo_netlist = std::move(arqv);
+    montarSequencias();
+    valido_sim = valid();
+    ordem_ok = true;
     return true;
 }
 
@@ -503,76 +810,692 @@ bool Circuito::salvar(const std::string& arq) const{
     return true;
 }
 
+// Salvar circuito em arquivo no formato binario, caso o circuito seja valido
+// Calcula a ordem de simulacao, se necessario, e grava plana e os blocos de simulacao
+bool Circuito::salvarBinario(const std::string& arq) const{
+
+    if(!prepararSimulacao()) return false;
+
+    std::ofstream arquivo(arq.c_str(), std::ios::binary);
+
+    if (!arquivo.is_open()) return false;
+
+    bool ok = escreverNetlistBinaria(arquivo, plana, bloco_sim, ciclo_sim);
+    arquivo.close();
+
+    return ok && !arquivo.fail();
+}
+
 /// ***********************
-/// SIMULACAO (funcao principal do circuito)
+/// Ordem de simulacao
 /// ***********************
 
-bool Circuito::simular(const std::vector<bool3S>& in_circ) {
-    /*
-        // TIPO DE DADO Port
-        Port:
-        vector<int> id_in
-        // ids das entradas da porta:
-        // id == índice+1 (se porta)
-        // == -índice-1 (se entrada)
-        bool3S out_port // Saída da porta
-        // DADOS GLOBAIS
-        vector<Port> ports
-        // portas do circuito
-        vector<int> id_out
-        // ids das saídas do circuito
-        // id == índice+1 (se porta)
-        // == -índice-1 (se entrada)
-        // ENTRADA:
-        vector<bool3S> in_circ
-        // Entradas do circuito
-        // SAÍDA
-        vector<bool3S> out_circ
-        // Saídas do circuito
-
-        // VARIÁVEIS LOCAIS:
-        bool tudo_def, alguma_def
-        vector<bool3S> in_port
-        // Entradas de uma porta
-        // SIMULAÇÃO DAS PORTAS
-        Para i de 0 a Num_ports-1
-        | ports[i].out_port ← UNDEF
-        Fim Para
-    */
-    bool tudo_def, alguma_def;
-    int id;
-    std::vector<bool3S> in_port;
-
-    for(int i=0; i<getNumPorts(); i++){
-        ports.at(i)->setOutput(bool3S::UNDEF);
+// Descarta a ordem de simulacao e muda a versao do circuito
+// Deve ser chamada sempre que mudar alguma porta ou ligacao do circuito
+void Circuito::invalidarOrdem(){
+    ordem_ok = false;
+    versao_sim = novaVersao();
+}
+
+// Calcula a ordem de simulacao
+// Usa o algoritmo de Tarjan (versao iterativa, para nao estourar a pilha em circuitos
+// profundos) sobre o grafo em que cada porta aponta para as portas que alimentam suas
+// entradas. O algoritmo fecha cada componente fortemente conexa depois de todas as
+// componentes das quais ela depende, de modo que os blocos jah saem em ordem topologica
+// Em seguida, copia as portas para plana nessa ordem e monta o indice de leitores
+void Circuito::calcularOrdem() const{
+    int NP = getNumPorts();
+
+    plana.clear();
+    bloco_sim.clear();
+    ciclo_sim.clear();
+    inicio_seq.clear();
+    ciclo_seq.clear();
+    inicio_leitores.clear();
+    leitores.clear();
+    valido_sim = valid();
+    if (!valido_sim) return;
+
+    std::vector<int> ordem;            // indices das portas na ordem de simulacao
+    ordem.reserve(NP);
+    std::vector<int> indice(NP, -1);   // ordem de descoberta de cada porta (-1: nao visitada)
+    std::vector<int> menor(NP, 0);     // menor indice alcancavel a partir da porta
+    std::vector<bool> na_pilha(NP, false);
+    std::vector<int> pilha;            // portas da componente em construcao
+    std::vector<std::pair<int,int> > busca; // (porta, proxima entrada a examinar)
+    int proximo = 0;
+
+    for(int raiz=0; raiz<NP; raiz++){
+        if(indice.at(raiz) >= 0) continue;
+        busca.push_back(std::make_pair(raiz, 0));
+        while(!busca.empty()){
+            int i = busca.back().first;
+            int j = busca.back().second;
+            if(j == 0){
+                indice.at(i) = menor.at(i) = proximo++;
+                pilha.push_back(i);
+                na_pilha.at(i) = true;
+            }
+            if(j < ports.at(i)->getNumInputs()){
+                busca.back().second++;
+                int id = ports.at(i)->getId_in(j);
+                if(id > 0){
+                    if(indice.at(id-1) < 0) busca.push_back(std::make_pair(id-1, 0));
+                    else if(na_pilha.at(id-1) && indice.at(id-1) < menor.at(i)) menor.at(i) = indice.at(id-1);
+                }
+                continue;
+            }
+            // Todas as entradas da porta i jah foram examinadas
+            busca.pop_back();
+            if(!busca.empty()){
+                int pai = busca.back().first;
+                if(menor.at(i) < menor.at(pai)) menor.at(pai) = menor.at(i);
+            }
+            if(menor.at(i) == indice.at(i)){
+                // i eh a raiz de uma componente: desempilha o bloco inteiro
+                int inicio = ordem.size();
+                int k;
+                do{
+                    k = pilha.back();
+                    pilha.pop_back();
+                    na_pilha.at(k) = false;
+                    ordem.push_back(k);
+                }while(k != i);
+                bool ciclo = (int(ordem.size())-inicio > 1);
+                for(int m=0; !ciclo && m<ports.at(i)->getNumInputs(); m++){
+                    if(ports.at(i)->getId_in(m) == i+1) ciclo = true;
+                }
+                bloco_sim.push_back(inicio);
+                ciclo_sim.push_back(ciclo);
+            }
+        }
+    }
+    bloco_sim.push_back(ordem.size());
+
+    // Nivel de cada bloco: 0 se soh depende das entradas do circuito, ou 1 a mais que
+    // o maior nivel dos blocos dos quais depende
+    int NB = ciclo_sim.size();
+    std::vector<int> bloco_porta(NP), nivel(NB, 0);
+    for(int b=0; b<NB; b++){
+        for(int k=bloco_sim[b]; k<bloco_sim[b+1]; k++) bloco_porta[ordem[k]] = b;
+    }
+    for(int b=0; b<NB; b++){
+        for(int k=bloco_sim[b]; k<bloco_sim[b+1]; k++){
+            const Port* porta = ports[ordem[k]];
+            for(int j=0; j<porta->getNumInputs(); j++){
+                int id = porta->getId_in(j);
+                if(id > 0 && bloco_porta[id-1] != b){
+                    nivel[b] = std::max(nivel[b], nivel[bloco_porta[id-1]]+1);
+                }
+            }
+        }
+    }
+
+    // Reordena os blocos por nivel e, dentro do nivel, pelo tipo da porta (os blocos com
+    // realimentacao por ultimo). Blocos do mesmo nivel nao dependem uns dos outros, entao
+    // a ordem continua topologica
+    std::vector<int> nova_ordem(NB);
+    for(int b=0; b<NB; b++) nova_ordem[b] = b;
+    std::stable_sort(nova_ordem.begin(), nova_ordem.end(), [&](int b1, int b2){
+        if(nivel[b1] != nivel[b2]) return nivel[b1] < nivel[b2];
+        if(ciclo_sim[b1] != ciclo_sim[b2]) return !ciclo_sim[b1];
+        return ports[ordem[bloco_sim[b1]]]->getTipo() < ports[ordem[bloco_sim[b2]]]->getTipo();
+    });
+    std::vector<int> ordem_blocos;
+    std::vector<int> inicio_blocos;
+    std::vector<bool> ciclo_blocos;
+    ordem_blocos.reserve(NP);
+    for(int n=0; n<NB; n++){
+        int b = nova_ordem[n];
+        inicio_blocos.push_back(ordem_blocos.size());
+        ciclo_blocos.push_back(ciclo_sim[b]);
+        for(int k=bloco_sim[b]; k<bloco_sim[b+1]; k++) ordem_blocos.push_back(ordem[k]);
+    }
+    inicio_blocos.push_back(NP);
+    ordem.swap(ordem_blocos);
+    bloco_sim.swap(inicio_blocos);
+    ciclo_sim.swap(ciclo_blocos);
+
+    // Representacao compacta, com as portas na ordem de simulacao
+    std::vector<TipoPorta> tipo;
+    std::vector<int32_t> sinal, inicio_in, sinal_in, sinal_out;
+    tipo.reserve(NP);
+    sinal.reserve(NP);
+    inicio_in.reserve(NP+1);
+    inicio_in.push_back(0);
+    for(int k=0; k<NP; k++){
+        const Port* porta = ports[ordem[k]];
+        tipo.push_back(porta->getTipo());
+        sinal.push_back(Nin+ordem[k]);
+        for(int j=0; j<porta->getNumInputs(); j++){
+            sinal_in.push_back(indiceSinal(porta->getId_in(j)));
+        }
+        inicio_in.push_back(sinal_in.size());
+    }
+    for(int j=0; j<getNumOutputs(); j++) sinal_out.push_back(indiceSinal(id_out[j]));
+    plana.Nin = Nin;
+    plana.tipo.assumir(std::move(tipo));
+    plana.sinal.assumir(std::move(sinal));
+    plana.inicio_in.assumir(std::move(inicio_in));
+    plana.sinal_in.assumir(std::move(sinal_in));
+    plana.sinal_out.assumir(std::move(sinal_out));
+
+    montarSequencias();
+}
+
+// Monta as sequencias de simulacao, o indice de leitores e o bytecode a partir de plana e
+// dos blocos
+void Circuito::montarSequencias() const{
+    int NP = plana.getNumPorts();
+    int NB = ciclo_sim.size();
+
+    {
+        // Os cones calculados com a ordem anterior nao valem mais
+        std::lock_guard<std::mutex> trava(trava_cones);
+        cones.clear();
+    }
+
+    inicio_seq.clear();
+    ciclo_seq.clear();
+
+    // Sequencias de simulacao: cada bloco com realimentacao eh uma sequencia, e os
+    // blocos consecutivos sem realimentacao com o mesmo tipo de porta formam uma sequencia
+    for(int b=0; b<NB; b++){
+        int k = bloco_sim[b];
+        if(ciclo_sim[b] || inicio_seq.empty() || ciclo_seq.back() ||
+           plana.tipo[k] != plana.tipo[inicio_seq.back()]){
+            inicio_seq.push_back(k);
+            ciclo_seq.push_back(ciclo_sim[b]);
+        }
+    }
+    inicio_seq.push_back(NP);
+
+    // Indice de leitores: primeiro conta os leitores de cada sinal, depois preenche
+    // (bloco_porta eh indexado pela posicao em plana)
+    std::vector<int> bloco_porta(NP);
+    for(int b=0; b<NB; b++){
+        for(int k=bloco_sim[b]; k<bloco_sim[b+1]; k++) bloco_porta[k] = b;
+    }
+    inicio_leitores.assign(plana.getNumSinais()+1, 0);
+    for(unsigned m=0; m<plana.sinal_in.size(); m++) inicio_leitores[plana.sinal_in[m]+1]++;
+    for(int s=0; s<plana.getNumSinais(); s++) inicio_leitores[s+1] += inicio_leitores[s];
+    leitores.resize(inicio_leitores.back());
+    std::vector<int> pos(inicio_leitores.begin(), inicio_leitores.end()-1);
+    for(int k=0; k<NP; k++){
+        for(int m=plana.inicio_in[k]; m<plana.inicio_in[k+1]; m++){
+            leitores[pos[plana.sinal_in[m]]++] = bloco_porta[k];
+        }
     }
 
+    bytecode.montar(plana, bloco_sim, ciclo_sim);
+}
+
+// Cone de entrada de um conjunto de saidas: as portas das quais as saidas dependem, como
+// trechos de plana que sao simulados em ordem. Cada trecho eh parte de uma sequencia sem
+// realimentacao (simulado com NetlistPlana::simularSequencia) ou um bloco com
+// realimentacao inteiro (simularCiclo): se uma porta de um bloco com realimentacao estah
+// no cone, todas estao
+struct Circuito::ConeSaidas {
+    struct Trecho {
+        int inicio, fim;
+        bool ciclo;
+    };
+    std::vector<Trecho> trechos;
+    // As ids das saidas, em ordem crescente e sem repeticoes
+    std::vector<int> ids;
+    // A versao do circuito (versao_sim) para a qual o cone foi calculado
+    unsigned long versao;
+};
+
+// Retorna o cone das saidas IdOutputs, calculando-o se necessario
+// As portas do cone sao marcadas percorrendo os blocos de tras para frente: as portas
+// das saidas sao marcadas primeiro, e cada bloco com alguma porta marcada marca todas
+// as suas portas e os sinais que elas leem (que estao em blocos anteriores ou no
+// proprio bloco). Em seguida, as portas marcadas de cada sequencia sao agrupadas em
+// trechos continuos
+std::shared_ptr<const Circuito::ConeSaidas> Circuito::coneSaidas(const std::vector<int>& IdOutputs) const{
+    {
+        std::lock_guard<std::mutex> trava(trava_cones);
+        auto it = cones.find(IdOutputs);
+        if(it != cones.end()){
+            it->second.uso = ++uso_cones;
+            return it->second.cone;
+        }
+    }
+
+    int NB = ciclo_sim.size();
+    std::vector<char> marcado(plana.getNumSinais(), false);
+    for(unsigned j=0; j<IdOutputs.size(); j++) marcado[plana.sinal_out[IdOutputs[j]-1]] = true;
+
+    for(int b=NB-1; b>=0; b--){
+        bool no_cone = false;
+        for(int k=bloco_sim[b]; !no_cone && k<bloco_sim[b+1]; k++) no_cone = marcado[plana.sinal[k]];
+        if(!no_cone) continue;
+        for(int k=bloco_sim[b]; k<bloco_sim[b+1]; k++){
+            marcado[plana.sinal[k]] = true;
+            for(int m=plana.inicio_in[k]; m<plana.inicio_in[k+1]; m++) marcado[plana.sinal_in[m]] = true;
+        }
+    }
+
+    std::shared_ptr<ConeSaidas> cone(new ConeSaidas);
+    cone->ids = IdOutputs;
+    cone->versao = versao_sim;
+    for(unsigned q = 0; q+1 < inicio_seq.size(); q++){
+        if(ciclo_seq[q]){
+            if(marcado[plana.sinal[inicio_seq[q]]]){
+                cone->trechos.push_back(ConeSaidas::Trecho{inicio_seq[q], inicio_seq[q+1], true});
+            }
+            continue;
+        }
+        for(int k = inicio_seq[q]; k < inicio_seq[q+1]; k++){
+            if(!marcado[plana.sinal[k]]) continue;
+            // Emenda com o trecho anterior se for continuo e da mesma sequencia
+            if(!cone->trechos.empty() && !cone->trechos.back().ciclo &&
+               cone->trechos.back().fim == k && k != inicio_seq[q]){
+                cone->trechos.back().fim = k+1;
+            }
+            else cone->trechos.push_back(ConeSaidas::Trecho{k, k+1, false});
+        }
+    }
+
+    std::lock_guard<std::mutex> trava(trava_cones);
+    // Se outra thread calculou o mesmo cone ao mesmo tempo, fica o primeiro
+    auto it = cones.find(IdOutputs);
+    if(it != cones.end()){
+        it->second.uso = ++uso_cones;
+        return it->second.cone;
+    }
+    if(cones.size() >= MAX_CONES_GUARDADOS){
+        auto antigo = cones.begin();
+        for(auto c = cones.begin(); c != cones.end(); ++c){
+            if(c->second.uso < antigo->second.uso) antigo = c;
+        }
+        cones.erase(antigo);
+    }
+    cones.insert(std::make_pair(IdOutputs, ConeGuardado{cone, ++uso_cones}));
+    return cone;
+}
+
+// Compila o circuito para codigo nativo
+// Se der erro, o codigo compilado anterior (de uma versao anterior) tambem eh descartado
+bool Circuito::compilar(const std::string& dir_cache){
+    compilado.reset();
+    erro_compilacao.clear();
+    if(!prepararSimulacao()){
+        erro_compilacao = "circuito invalido";
+        return false;
+    }
+    compilado = CircuitoCompilado::compilar(*this, dir_cache, erro_compilacao);
+    return compilado != nullptr;
+}
+
+// Retorna true se ha codigo compilado para a versao atual do circuito
+bool Circuito::usaCodigoCompilado() const{
+    return compilado != nullptr && compilado->getVersao() == versao_sim;
+}
+
+// Retorna a descricao do erro da ultima compilacao
+const std::string& Circuito::getErroCompilacao() const{
+    return erro_compilacao;
+}
+
+// Calcula a ordem de simulacao, caso ainda nao esteja calculada
+// Usa a trava para que, se varias threads chamarem ao mesmo tempo, soh uma calcule
+bool Circuito::prepararSimulacao() const{
+    if(!ordem_ok.load(std::memory_order_acquire)){
+        std::lock_guard<std::mutex> trava(trava_ordem);
+        if(!ordem_ok.load(std::memory_order_relaxed)){
+            calcularOrdem();
+            ordem_ok.store(true, std::memory_order_release);
+        }
+    }
+    return valido_sim;
+}
+
+// Dimensiona os vetores do contexto para o maior tamanho que as simulacoes vao usar
+bool Circuito::prepararContexto(ContextoSimulacao& Ctx) const{
+    if(!prepararSimulacao()) return false;
+
+    int NB = ciclo_sim.size();
+    int maior_bloco = 0;
+    for(int b=0; b<NB; b++) maior_bloco = std::max(maior_bloco, bloco_sim[b+1]-bloco_sim[b]);
+
+    Ctx.num_entradas = Nin;
+    Ctx.val_sinal.resize(plana.getNumSinais());
+    Ctx.out_circ.resize(getNumOutputs());
+    Ctx.val_sinal64.resize(plana.getNumSinais());
+    Ctx.out_circ64.resize(getNumOutputs());
+    Ctx.val_bloco.resize((plana.getNumSinais()+1)*TAMANHO_BLOCO);
+    Ctx.fila_blocos.reserve(NB);
+    Ctx.bloco_na_fila.resize(NB, false);
+    Ctx.anterior_bloco.reserve(maior_bloco);
+    return true;
+}
+
+// Simula um bloco com realimentacao: as portas do bloco comecam indefinidas e sao
+// resimuladas enquanto alguma delas passar a ter valor definido
+void Circuito::simularCiclo(int inicio, int fim, ContextoSimulacao& Ctx) const{
+    bool3S* val = Ctx.val_sinal.data();
+    bool alguma_def;
+
+    for(int k = inicio; k < fim; k++){
+        val[plana.sinal[k]] = bool3S::UNDEF;
+    }
     do{
-        tudo_def = true;
         alguma_def = false;
+        for(int k = inicio; k < fim; k++){
+            bool3S& out = val[plana.sinal[k]];
+            if(out == bool3S::UNDEF){
+                out = plana.calcular(k, val);
+                if(out != bool3S::UNDEF) alguma_def = true;
+            }
+        }
+    }while(alguma_def);
+}
+
+// Calcula as saidas do circuito a partir dos valores dos sinais
+void Circuito::calcularSaidas(ContextoSimulacao& Ctx) const{
+    for(int j = 0; j<getNumOutputs(); j++){
+        Ctx.out_circ[j] = Ctx.val_sinal[plana.sinal_out[j]];
+    }
+}
+
+// Retorna o indice do sinal cuja id eh IdOrig
+// As entradas do circuito sao os primeiros Nin sinais, seguidas pelas portas
+int Circuito::indiceSinal(int IdOrig) const{
+    if(IdOrig > 0) return Nin+IdOrig-1;
+    return -IdOrig-1;
+}
+
+/// ***********************
+/// SIMULACAO (funcao principal do circuito)
+/// ***********************
+
+// Simula o cone das saidas pedidas usando o contexto do proprio circuito e copia as
+// saidas para out_circ
+bool Circuito::simularSaidas(const std::vector<bool3S>& in_circ, const std::vector<int>& IdOutputs){
+    if(!simularSaidas(in_circ, IdOutputs, contexto)) return false;
+    out_circ = contexto.out_circ;
+    return true;
+}
+
+// Confere as ids e procura o cone, que eh guardado com as ids em ordem crescente e sem
+// repeticoes
+std::shared_ptr<const Circuito::ConeSaidas> Circuito::prepararSaidas(const std::vector<int>& IdOutputs) const{
+    if(!prepararSimulacao()) return nullptr;
+    for(unsigned j=0; j<IdOutputs.size(); j++){
+        if(!validIdOutput(IdOutputs[j])) return nullptr;
+    }
+
+    if(std::is_sorted(IdOutputs.begin(), IdOutputs.end()) &&
+       std::adjacent_find(IdOutputs.begin(), IdOutputs.end()) == IdOutputs.end()){
+        return coneSaidas(IdOutputs);
+    }
+    std::vector<int> ids(IdOutputs);
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return coneSaidas(ids);
+}
+
+// Igual a simular, mas percorrendo soh os trechos de plana que formam o cone das saidas
+// Os sinais fora do cone nao sao usados e por isso nao sao apagados: as portas do cone
+// leem apenas entradas do circuito e portas do cone, que sao calculadas antes (os blocos
+// com realimentacao sao apagados por simularCiclo)
+bool Circuito::simularSaidas(const std::vector<bool3S>& in_circ, const std::shared_ptr<const ConeSaidas>& Cone,
+                             ContextoSimulacao& Ctx) const{
+    // Se a versao nao mudou, a ordem de simulacao usada pelo cone continua calculada
+    if(Cone == nullptr || Cone->versao != versao_sim || int(in_circ.size()) != getNumInputs()) return false;
+
+    Ctx.num_entradas = Nin;
+    Ctx.val_sinal.resize(plana.getNumSinais());
+    Ctx.out_circ.resize(getNumOutputs());
+    bool3S* val = Ctx.val_sinal.data();
+    std::copy(in_circ.begin(), in_circ.end(), val);
+
+    for(unsigned t = 0; t < Cone->trechos.size(); t++){
+        const ConeSaidas::Trecho& T = Cone->trechos[t];
+        if(!T.ciclo) plana.simularSequencia(T.inicio, T.fim, val);
+        else simularCiclo(T.inicio, T.fim, Ctx);
+    }
+    std::fill(Ctx.out_circ.begin(), Ctx.out_circ.end(), bool3S::UNDEF);
+    for(unsigned j=0; j<Cone->ids.size(); j++){
+        Ctx.out_circ[Cone->ids[j]-1] = val[plana.sinal_out[Cone->ids[j]-1]];
+    }
+
+    // Como nem todas as portas foram simuladas, o estado nao serve para a simulacao
+    // incremental
+    Ctx.versao_estado = 0;
+    return true;
+}
 
-        for(int i = 0; i<getNumPorts(); i++){
-            if(ports.at(i)->getOutput() == bool3S::UNDEF){
-                for(int j = 0; j < ports.at(i)->getNumInputs(); j++){
-                    id = ports.at(i)->getId_in(j);
-                    if(id>0) in_port.push_back(ports.at(id-1)->getOutput());
-                    else in_port.push_back(in_circ.at(-id-1));
+// Procura o cone das saidas pedidas e simula com ele
+bool Circuito::simularSaidas(const std::vector<bool3S>& in_circ, const std::vector<int>& IdOutputs,
+                             ContextoSimulacao& Ctx) const{
+    return simularSaidas(in_circ, prepararSaidas(IdOutputs), Ctx);
+}
+
+// Simula o circuito usando o contexto do proprio circuito e copia as saidas para out_circ
+bool Circuito::simular(const std::vector<bool3S>& in_circ) {
+    if(!prepararSimulacao() || int(in_circ.size()) != getNumInputs()) return false;
+    bool tudo_def = simular(in_circ, contexto);
+    out_circ = contexto.out_circ;
+    return tudo_def;
+}
+
+// As entradas do circuito sao copiadas para os primeiros sinais de Ctx.val_sinal, e as
+// portas sao simuladas percorrendo plana em ordem, uma sequencia de cada vez
+bool Circuito::simular(const std::vector<bool3S>& in_circ, ContextoSimulacao& Ctx) const {
+    if(!prepararSimulacao() || int(in_circ.size()) != getNumInputs()) return false;
+
+    Ctx.num_entradas = Nin;
+    Ctx.val_sinal.resize(plana.getNumSinais());
+    Ctx.out_circ.resize(getNumOutputs());
+    bool3S* val = Ctx.val_sinal.data();
+    std::copy(in_circ.begin(), in_circ.end(), val);
+
+    for(unsigned q = 0; q+1 < inicio_seq.size(); q++){
+        if(!ciclo_seq[q]){
+            // Portas sem realimentacao: todas as entradas jah estao calculadas
+            plana.simularSequencia(inicio_seq[q], inicio_seq[q+1], val);
+        }
+        else simularCiclo(inicio_seq[q], inicio_seq[q+1], Ctx);
+    }
+    calcularSaidas(Ctx);
+
+    // O estado serve para uma proxima simulacao incremental
+    Ctx.versao_estado = versao_sim;
+
+    // Retorna se nenhuma porta ficou indefinida
+    for(int s = Nin; s < plana.getNumSinais(); s++){
+        if(val[s] == bool3S::UNDEF) return false;
+    }
+    return true;
+}
+
+// Simulacao incremental usando o contexto do proprio circuito
+bool Circuito::simularIncremental(const std::vector<bool3S>& in_circ) {
+    if(!simularIncremental(in_circ, contexto)) return false;
+    out_circ = contexto.out_circ;
+    return true;
+}
+
+// Simulacao incremental
+// Os blocos a resimular ficam em um heap ordenado pelo indice do bloco. Como os blocos
+// estao em ordem topologica, quando um bloco sai do heap todos os blocos dos quais ele
+// depende jah foram resimulados, e cada bloco eh resimulado no maximo uma vez
+// Um bloco com realimentacao eh resimulado inteiro, a partir de UNDEF, como em simular
+bool Circuito::simularIncremental(const std::vector<bool3S>& in_circ, ContextoSimulacao& Ctx) const {
+    if(!prepararSimulacao() || int(in_circ.size()) != getNumInputs()) return false;
+
+    // Sem estado anterior deste circuito: simulacao completa
+    if(Ctx.versao_estado != versao_sim){
+        // O retorno de simular indica portas indefinidas, que aqui nao sao erro
+        simular(in_circ, Ctx);
+        return true;
+    }
+
+    bool3S* val = Ctx.val_sinal.data();
+    std::vector<int>& fila = Ctx.fila_blocos;
+    std::vector<char>& na_fila = Ctx.bloco_na_fila;
+    na_fila.resize(bloco_sim.size()-1, false);
+    fila.clear();
+
+    // Coloca no heap os blocos que leem o sinal s, exceto o bloco atual
+    auto agendarLeitores = [&](int s, int atual){
+        for(int k = inicio_leitores[s]; k < inicio_leitores[s+1]; k++){
+            int b = leitores[k];
+            if(b != atual && !na_fila[b]){
+                na_fila[b] = true;
+                fila.push_back(b);
+                std::push_heap(fila.begin(), fila.end(), std::greater<int>());
+            }
+        }
+    };
+
+    // As entradas da simulacao anterior estao nos primeiros sinais
+    for(int i = 0; i < getNumInputs(); i++){
+        if(in_circ[i] != val[i]){
+            val[i] = in_circ[i];
+            agendarLeitores(i, -1);
+        }
+    }
+
+    while(!fila.empty()){
+        std::pop_heap(fila.begin(), fila.end(), std::greater<int>());
+        int b = fila.back();
+        fila.pop_back();
+        na_fila[b] = false;
+
+        int inicio = bloco_sim[b];
+        int fim = bloco_sim[b+1];
+
+        if(!ciclo_sim[b]){
+            int s = plana.sinal[inicio];
+            bool3S anterior = val[s];
+            val[s] = plana.calcular(inicio, val);
+            if(val[s] != anterior) agendarLeitores(s, b);
+            continue;
+        }
+
+        Ctx.anterior_bloco.clear();
+        for(int k = inicio; k < fim; k++) Ctx.anterior_bloco.push_back(val[plana.sinal[k]]);
+        simularCiclo(inicio, fim, Ctx);
+        for(int k = inicio; k < fim; k++){
+            int s = plana.sinal[k];
+            if(val[s] != Ctx.anterior_bloco[k-inicio]) agendarLeitores(s, b);
+        }
+    }
+
+    calcularSaidas(Ctx);
+    return true;
+}
+
+// Simula o circuito para 64 combinacoes de entrada, usando o contexto do proprio circuito
+bool Circuito::simular64(const std::vector<bool3S_64>& in_circ) {
+    return simular64(in_circ, contexto);
+}
+
+// Simula o circuito para 64 combinacoes de entrada de uma soh vez
+// Como os operadores 3S sao monotonicos (uma entrada que passa de UNDEF para definida
+// nunca muda uma saida jah definida), simular todas as portas de um bloco com
+// realimentacao ateh nada mudar leva ao mesmo resultado do metodo simular, que
+// soh resimula as portas ainda indefinidas
+bool Circuito::simular64(const std::vector<bool3S_64>& in_circ, ContextoSimulacao& Ctx) const {
+    bool mudou;
+
+    if(!prepararSimulacao() || int(in_circ.size()) != getNumInputs()) return false;
+
+    Ctx.out_circ64.resize(getNumOutputs());
+    if(usaCodigoCompilado()){
+        compilado->simularLote(in_circ.data(), 1, Ctx.out_circ64.data());
+        return true;
+    }
+
+    Ctx.val_sinal64.resize(plana.getNumSinais());
+    bool3S_64* val = Ctx.val_sinal64.data();
+    std::copy(in_circ.begin(), in_circ.end(), val);
+
+    for(unsigned q = 0; q+1 < inicio_seq.size(); q++){
+        int inicio = inicio_seq[q];
+        int fim = inicio_seq[q+1];
+
+        if(!ciclo_seq[q]){
+            plana.simularSequencia(inicio, fim, val);
+            continue;
+        }
+
+        for(int k = inicio; k < fim; k++){
+            val[plana.sinal[k]] = toBool3S_64(bool3S::UNDEF);
+        }
+        do{
+            mudou = false;
+            for(int k = inicio; k < fim; k++){
+                bool3S_64 out = plana.calcular(k, val);
+                if(out != val[plana.sinal[k]]){
+                    val[plana.sinal[k]] = out;
+                    mudou = true;
                 }
-                ports.at(i)->simular(in_port);
-                if(ports.at(i)->getOutput() == bool3S::UNDEF) tudo_def = false;
-                else alguma_def = true;
+            }
+        }while(mudou);
+    }
+
+    for(int j = 0; j<getNumOutputs(); j++){
+        Ctx.out_circ64[j] = val[plana.sinal_out[j]];
+    }
+    return true;
+}
+
+// Simula o circuito para 64*NPalavras combinacoes de entrada, usando o contexto
+// do proprio circuito
+bool Circuito::simularLote(const std::vector<bool3S_64>& in_circ, int NPalavras,
+                           std::vector<bool3S_64>& out_lote) {
+    return simularLote(in_circ, NPalavras, out_lote, contexto);
+}
+
+// Simula o circuito para 64*NPalavras combinacoes de entrada, em blocos de
+// 64*PALAVRAS_BLOCO combinacoes, executando o bytecode do circuito em cada bloco
+bool Circuito::simularLote(const std::vector<bool3S_64>& in_circ, int NPalavras,
+                           std::vector<bool3S_64>& out_lote, ContextoSimulacao& Ctx) const {
+    const int W = PALAVRAS_BLOCO;
+
+    if(!prepararSimulacao() || NPalavras <= 0 ||
+       int(in_circ.size()) != getNumInputs()*NPalavras) return false;
+
+    if(usaCodigoCompilado()){
+        out_lote.resize(getNumOutputs()*NPalavras);
+        compilado->simularLote(in_circ.data(), NPalavras, out_lote.data());
+        return true;
+    }
+
+    // Um bloco para cada sinal, mais um bloco temporario no final
+    std::vector<uint64_t>& valores = Ctx.val_bloco;
+    valores.resize(bytecode.getTamanhoValores());
+    out_lote.resize(getNumOutputs()*NPalavras);
+
+    for(int w0 = 0; w0 < NPalavras; w0 += W){
+        int nw = std::min(W, NPalavras-w0);
+
+        // Copia as entradas do bloco (as palavras que sobram no ultimo bloco ficam UNDEF)
+        for(int i = 0; i < getNumInputs(); i++){
+            uint64_t* v = &valores[i*TAMANHO_BLOCO];
+            for(int k = 0; k < W; k++){
+                bool3S_64 x = (k < nw ? in_circ[i*NPalavras+w0+k] : toBool3S_64(bool3S::UNDEF));
+                v[k] = x.T;
+                v[W+k] = x.F;
             }
         }
 
-    }while(!tudo_def && alguma_def);
+        bytecode.executar(valores.data());
 
-    for(unsigned j = 0; j<unsigned(getNumOutputs()); j++){
-        id = id_out.at(j);
-        if(id > 0) out_circ.at(j) = ports.at(id-1)->getOutput();
-        else out_circ.at(j) = in_circ.at(-id-1);
+        for(int j = 0; j < getNumOutputs(); j++){
+            const uint64_t* v = &valores[plana.sinal_out[j]*TAMANHO_BLOCO];
+            for(int k = 0; k < nw; k++){
+                out_lote[j*NPalavras+w0+k] = bool3S_64{v[k], v[W+k]};
+            }
+        }
     }
-    return tudo_def;
-};
+    return true;
+}
 
 std::ostream& operator<<(std::ostream& O, const Circuito& C){
     if(!C.valid()){
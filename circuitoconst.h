@@ -0,0 +1,273 @@
+#ifndef _CIRCUITOCONST_H_
+#define _CIRCUITOCONST_H_
+
+//Autores:  Luisa de Moura Galvão Mathias
+//          Marcos Paulo Barbosa
+
+#include <array>
+#include <type_traits>
+#include <utility> // para std::index_sequence
+#include "bool3S.h"
+#include "bool3S_64.h"
+#include "port.h"
+
+///
+/// CIRCUITOS CONHECIDOS EM TEMPO DE COMPILACAO
+///
+
+// Um circuito fixo pode ser descrito como uma constante (NetlistConst) e simulado pela
+// classe CircuitoConst, sem criar nenhum objeto Circuito ou Port: a ordem de simulacao
+// eh calculada pelo compilador e cada porta vira uma expressao com o tipo e as entradas
+// conhecidos, de modo que a simulacao eh toda expandida (inline), sem alocacao de
+// memoria e sem custo de inicializacao. Serve para embutir circuitos de referencia em
+// outros programas
+// As ids seguem a mesma convencao de Port::id_in e Circuito (entradas de -1 a -Nin,
+// portas de 1 a Nports), e os erros que Circuito::valid soh encontra durante a execucao
+// (numero de entradas de porta invalido, ids fora dos limites) sao erros de compilacao
+// Os metodos tambem sao constexpr, de modo que o circuito pode ser simulado pelo
+// proprio compilador (por exemplo, em um static_assert)
+// Como a ordem eh calculada pelo compilador, eh indicado para circuitos pequenos (ateh
+// algumas centenas de portas)
+
+// Numero maximo de entradas de uma porta de um NetlistConst (o mesmo da interface)
+const int MAX_INPUTS_CONST = 4;
+
+// Uma porta: o tipo, o numero de entradas e as ids das origens das entradas
+struct PortaConst {
+  TipoPorta tipo;
+  int num_inputs;
+  int id_in[MAX_INPUTS_CONST];
+};
+
+// A descricao de um circuito com NIN entradas, NOUT saidas e NPORTS portas
+// A porta cuja id eh p estah em portas[p-1], e id_out[j-1] eh a id da origem da saida j
+// Exemplo (o circuito de circuito.txt estah no final deste arquivo):
+//   inline constexpr NetlistConst<2,1,1> NETLIST_AND = {{{TipoPorta::AN, 2, {-1, -2}}}, {1}};
+template<int NIN, int NOUT, int NPORTS>
+struct NetlistConst {
+  static constexpr int Nin = NIN;
+  static constexpr int Nout = NOUT;
+  static constexpr int Nports = NPORTS;
+
+  PortaConst portas[NPORTS];
+  int id_out[NOUT];
+};
+
+/// ***********************
+/// Validacao
+/// ***********************
+
+// Retorna true se IdOrig eh uma id de entrada do circuito ou de porta
+template<class N>
+constexpr bool validIdOrigConst(const N& Net, int IdOrig)
+{
+  (void)Net;
+  return (IdOrig<=-1 && IdOrig>=-N::Nin) || (IdOrig>=1 && IdOrig<=N::Nports);
+}
+
+// Retorna true se todas as portas tem um numero de entradas valido para o seu tipo
+// (1 para NT, de 2 a MAX_INPUTS_CONST para as demais)
+template<class N>
+constexpr bool numInputsValidosConst(const N& Net)
+{
+  for (int p=0; p<N::Nports; p++)
+  {
+    int NI = Net.portas[p].num_inputs;
+    if (Net.portas[p].tipo==TipoPorta::NT ? NI!=1 : (NI<2 || NI>MAX_INPUTS_CONST)) return false;
+  }
+  return true;
+}
+
+// Retorna true se as origens das entradas de todas as portas sao validas
+template<class N>
+constexpr bool idsInputsValidasConst(const N& Net)
+{
+  for (int p=0; p<N::Nports; p++)
+  {
+    for (int i=0; i<Net.portas[p].num_inputs; i++)
+    {
+      if (!validIdOrigConst(Net, Net.portas[p].id_in[i])) return false;
+    }
+  }
+  return true;
+}
+
+// Retorna true se as origens de todas as saidas sao validas
+template<class N>
+constexpr bool idsOutputsValidasConst(const N& Net)
+{
+  for (int j=0; j<N::Nout; j++)
+  {
+    if (!validIdOrigConst(Net, Net.id_out[j])) return false;
+  }
+  return true;
+}
+
+/// ***********************
+/// Ordem de simulacao
+/// ***********************
+
+// A ordem em que as portas sao simuladas: indices (id-1) das portas
+// As num_ordenadas primeiras estao em ordem topologica (cada uma soh depende das
+// entradas do circuito e das portas anteriores) e sao simuladas uma unica vez. As
+// demais estao em blocos com realimentacao ou dependem deles, e sao simuladas
+// repetidamente, a partir de UNDEF, ateh nenhuma mudar (o mesmo resultado de
+// Circuito::simular, pois os operadores 3S sao monotonicos)
+template<int NPORTS>
+struct OrdemConst {
+  int porta[NPORTS];
+  int num_ordenadas;
+};
+
+template<class N>
+constexpr OrdemConst<N::Nports> calcularOrdemConst(const N& Net)
+{
+  OrdemConst<N::Nports> O{};
+  bool colocada[N::Nports] = {};
+  int num = 0;
+  // Coloca, a cada passada, as portas cujas entradas jah foram todas colocadas
+  for (bool mudou = true; mudou; )
+  {
+    mudou = false;
+    for (int p=0; p<N::Nports; p++)
+    {
+      if (colocada[p]) continue;
+      bool pronta = true;
+      for (int i=0; i<Net.portas[p].num_inputs && i<MAX_INPUTS_CONST; i++)
+      {
+        int id = Net.portas[p].id_in[i];
+        if (id>0 && id<=N::Nports && !colocada[id-1]) pronta = false;
+      }
+      if (pronta)
+      {
+        O.porta[num++] = p;
+        colocada[p] = mudou = true;
+      }
+    }
+  }
+  O.num_ordenadas = num;
+  for (int p=0; p<N::Nports; p++) if (!colocada[p]) O.porta[num++] = p;
+  return O;
+}
+
+/// ***********************
+/// Simulacao
+/// ***********************
+
+// Simulador do circuito descrito pela constante Net (um NetlistConst)
+// V eh bool3S (uma combinacao de entradas) ou bool3S_64 (64 combinacoes de uma vez)
+template<const auto& Net>
+class CircuitoConst {
+private:
+  typedef std::remove_cv_t<std::remove_reference_t<decltype(Net)>> N;
+
+  static_assert(N::Nin>0 && N::Nout>0 && N::Nports>0,
+                "o circuito deve ter pelo menos uma entrada, uma saida e uma porta");
+  static_assert(numInputsValidosConst(Net), "porta com numero de entradas invalido");
+  static_assert(idsInputsValidasConst(Net), "porta com id de origem de entrada invalida");
+  static_assert(idsOutputsValidasConst(Net), "saida com id de origem invalida");
+
+  static constexpr OrdemConst<N::Nports> ORDEM = calcularOrdemConst(Net);
+
+  // Indice do sinal cuja id eh IdOrig: as entradas do circuito sao os sinais 0 a Nin-1,
+  // seguidas pelas portas (como em Circuito)
+  static constexpr int sinal(int IdOrig) { return IdOrig>0 ? N::Nin+IdOrig-1 : -IdOrig-1; }
+
+  // Calcula a saida da porta de indice P a partir dos valores de todos os sinais
+  template<int P, class V, std::size_t... I>
+  static constexpr V calcularPorta(const V* val, std::index_sequence<I...>)
+  {
+    constexpr TipoPorta T = Net.portas[P].tipo;
+    V out = val[sinal(Net.portas[P].id_in[0])];
+    if constexpr (T==TipoPorta::AN || T==TipoPorta::NA) ((out = out & val[sinal(Net.portas[P].id_in[I+1])]), ...);
+    else if constexpr (T==TipoPorta::OR || T==TipoPorta::NO) ((out = out | val[sinal(Net.portas[P].id_in[I+1])]), ...);
+    else if constexpr (T==TipoPorta::XO || T==TipoPorta::NX) ((out = out ^ val[sinal(Net.portas[P].id_in[I+1])]), ...);
+    if constexpr (T==TipoPorta::NT || T==TipoPorta::NA || T==TipoPorta::NO || T==TipoPorta::NX) return ~out;
+    else return out;
+  }
+
+  // Simula a porta na posicao K de ORDEM; retorna true se o valor dela mudou
+  template<int K, class V>
+  static constexpr bool simularPorta(V* val)
+  {
+    constexpr int P = ORDEM.porta[K];
+    V out = calcularPorta<P>(val, std::make_index_sequence<Net.portas[P].num_inputs-1>());
+    bool mudou = (out != val[N::Nin+P]);
+    val[N::Nin+P] = out;
+    return mudou;
+  }
+
+  // Simula as portas nas posicoes INICIO+K de ORDEM; retorna true se alguma mudou
+  template<int INICIO, class V, std::size_t... K>
+  static constexpr bool simularPortas(V* val, std::index_sequence<K...>)
+  {
+    bool mudou = false;
+    (void)val; // quando nao ha portas
+    ((mudou |= simularPorta<INICIO+int(K)>(val)), ...);
+    return mudou;
+  }
+
+public:
+  static constexpr int Nin = N::Nin;
+  static constexpr int Nout = N::Nout;
+  static constexpr int Nports = N::Nports;
+  // true se o circuito tem realimentacao
+  static constexpr bool temCiclo = (ORDEM.num_ordenadas < N::Nports);
+
+  // Simula o circuito: in_circ tem Nin valores (a entrada cuja id eh -(i+1) em
+  // in_circ[i]) e out_circ recebe os Nout valores das saidas (id j+1 em out_circ[j])
+  template<class V>
+  static constexpr void simular(const V* in_circ, V* out_circ)
+  {
+    // Os sinais comecam todos UNDEF (V{} tem os bits ou o valor iguais a 0)
+    V val[N::Nin+N::Nports] = {};
+    for (int i=0; i<N::Nin; i++) val[i] = in_circ[i];
+
+    simularPortas<0>(val, std::make_index_sequence<ORDEM.num_ordenadas>());
+    while (simularPortas<ORDEM.num_ordenadas>(val, std::make_index_sequence<N::Nports-ORDEM.num_ordenadas>()));
+
+    for (int j=0; j<N::Nout; j++) out_circ[j] = val[sinal(Net.id_out[j])];
+  }
+
+  // Igual ao anterior, recebendo e retornando std::array
+  template<class V>
+  static constexpr std::array<V, N::Nout> simular(const std::array<V, N::Nin>& in_circ)
+  {
+    std::array<V, N::Nout> out_circ{};
+    simular(in_circ.data(), out_circ.data());
+    return out_circ;
+  }
+};
+
+///
+/// EXEMPLO: O CIRCUITO DE circuito.txt
+///
+
+inline constexpr NetlistConst<2,2,5> NETLIST_EXEMPLO = {
+  {
+    {TipoPorta::NA, 2, {-1, -2}},
+    {TipoPorta::OR, 2, {1, 4}},
+    {TipoPorta::AN, 2, {-1, 3}},
+    {TipoPorta::NT, 1, {-2}},
+    {TipoPorta::NT, 1, {3}}
+  },
+  {2, 5}
+};
+
+typedef CircuitoConst<NETLIST_EXEMPLO> CircuitoExemplo;
+
+// Algumas linhas da tabela verdade, conferidas pelo compilador (a porta 3 eh ligada a
+// si mesma, entao a saida 2 soh fica definida quando a entrada 1 eh FALSE)
+static_assert(CircuitoExemplo::temCiclo, "");
+static_assert(CircuitoExemplo::simular(std::array<bool3S,2>{bool3S::FALSE, bool3S::UNDEF})[0]==bool3S::TRUE &&
+              CircuitoExemplo::simular(std::array<bool3S,2>{bool3S::FALSE, bool3S::UNDEF})[1]==bool3S::TRUE, "");
+static_assert(CircuitoExemplo::simular(std::array<bool3S,2>{bool3S::TRUE, bool3S::TRUE})[0]==bool3S::FALSE &&
+              CircuitoExemplo::simular(std::array<bool3S,2>{bool3S::TRUE, bool3S::TRUE})[1]==bool3S::UNDEF, "");
+static_assert(CircuitoExemplo::simular(std::array<bool3S,2>{bool3S::UNDEF, bool3S::FALSE})[0]==bool3S::TRUE &&
+              CircuitoExemplo::simular(std::array<bool3S,2>{bool3S::UNDEF, bool3S::FALSE})[1]==bool3S::UNDEF, "");
+// As mesmas linhas com bool3S_64: bit 0 com as entradas (FALSE, UNDEF), bit 1 com
+// (TRUE, TRUE) e os demais bits com (UNDEF, UNDEF)
+static_assert(CircuitoExemplo::simular(std::array<bool3S_64,2>{bool3S_64{0b10, 0b01}, bool3S_64{0b10, 0}})[0]==bool3S_64{0b01, 0b10} &&
+              CircuitoExemplo::simular(std::array<bool3S_64,2>{bool3S_64{0b10, 0b01}, bool3S_64{0b10, 0}})[1]==bool3S_64{0b01, 0}, "");
+
+#endif // _CIRCUITOCONST_H_
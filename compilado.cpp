@@ -0,0 +1,306 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include "circuito.h"
+#include "compilado.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define COMPILADO_POSIX
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//Autores:  Luisa de Moura Galvão Mathias
+//          Marcos Paulo Barbosa
+
+// Nome da funcao gerada na biblioteca
+static const char* NOME_FUNCAO = "simular_circuito3S";
+
+// Opcoes passadas ao compilador (alem do arquivo de saida e do codigo)
+static const char* OPCOES_COMPILADOR = "-O2 -shared -fPIC";
+
+// Inicio do codigo gerado: o tipo V tem o mesmo formato de bool3S_64, e as funcoes N, E,
+// O e X sao os operadores ~, &, | e ^ de bool3S_64. M atribui um valor e retorna true
+// se ele mudou (usada nos blocos com realimentacao)
+static const char* PROLOGO_CODIGO =
+  "// Codigo gerado por CircuitoCompilado::gerarCodigo\n"
+  "#include <cstdint>\n"
+  "struct V { uint64_t T, F; };\n"
+  "static inline V N(V a) { return V{a.F, a.T}; }\n"
+  "static inline V E(V a, V b) { return V{a.T & b.T, a.F | b.F}; }\n"
+  "static inline V O(V a, V b) { return V{a.T | b.T, a.F & b.F}; }\n"
+  "static inline V X(V a, V b) { return V{(a.T & b.F) | (a.F & b.T), (a.T & b.T) | (a.F & b.F)}; }\n"
+  "static inline bool M(V& s, V n) { bool m = (s.T != n.T) | (s.F != n.F); s = n; return m; }\n";
+
+// Hash FNV-1a de 64 bits de um texto
+static uint64_t hashTexto(const std::string& S)
+{
+  uint64_t h = 14695981039346656037ull;
+  for (unsigned i=0; i<S.size(); i++)
+  {
+    h ^= uint8_t(S[i]);
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+std::string diretorioCacheCompilados()
+{
+  const char* dir = getenv("CIRCUITO_CACHE");
+  if (dir!=nullptr && dir[0]!='\0') return dir;
+  const char* home = getenv("HOME");
+  if (home!=nullptr && home[0]!='\0') return std::string(home) + "/.cache/circuito3S";
+  return "";
+}
+
+///
+/// GERACAO DO CODIGO
+///
+
+// Escreve em O a expressao da porta na posicao k de plana, com os sinais chamados
+// s<indice do sinal>: as portas de varias entradas viram chamadas encadeadas de E, O
+// ou X, e as portas negadas (NT, NA, NO, NX) sao envolvidas por N
+static void escreverExpressao(std::ostream& O, const NetlistPlana& P, int k)
+{
+  const char* op = "";
+  bool negada = false;
+  switch (P.tipo[k])
+  {
+  case TipoPorta::NT: negada = true; break;
+  case TipoPorta::AN: op = "E"; break;
+  case TipoPorta::NA: op = "E"; negada = true; break;
+  case TipoPorta::OR: op = "O"; break;
+  case TipoPorta::NO: op = "O"; negada = true; break;
+  case TipoPorta::XO: op = "X"; break;
+  case TipoPorta::NX: op = "X"; negada = true; break;
+  }
+  int primeira = P.inicio_in[k], N = P.inicio_in[k+1]-primeira;
+
+  if (negada) O << "N(";
+  for (int m=1; m<N; m++) O << op << '(';
+  O << 's' << P.sinal_in[primeira];
+  for (int m=1; m<N; m++) O << ", s" << P.sinal_in[primeira+m] << ')';
+  if (negada) O << ')';
+}
+
+std::string CircuitoCompilado::gerarCodigo(const Circuito& C)
+{
+  const NetlistPlana& P = C.plana;
+  const int Nin = C.getNumInputs();
+  const int Nout = C.getNumOutputs();
+  const int NB = C.ciclo_sim.size();
+  std::ostringstream O;
+
+  O << PROLOGO_CODIGO;
+  O << "// Circuito com " << Nin << " entradas, " << Nout << " saidas e "
+    << P.getNumPorts() << " portas\n";
+  O << "extern \"C\" void " << NOME_FUNCAO << "(const void* entrada, void* saida, int NPalavras)\n";
+  O << "{\n";
+  O << "  const V* in = static_cast<const V*>(entrada);\n";
+  O << "  V* out = static_cast<V*>(saida);\n";
+  O << "  for (int w = 0; w < NPalavras; w++)\n";
+  O << "  {\n";
+  for (int i=0; i<Nin; i++) O << "    const V s" << i << " = in[" << i << "*NPalavras + w];\n";
+
+  for (int b=0; b<NB; b++)
+  {
+    if (!C.ciclo_sim[b])
+    {
+      int k = C.bloco_sim[b];
+      O << "    const V s" << P.sinal[k] << " = ";
+      escreverExpressao(O, P, k);
+      O << ";\n";
+      continue;
+    }
+    // Bloco com realimentacao: as portas comecam UNDEF e sao recalculadas ateh estabilizar
+    for (int k=C.bloco_sim[b]; k<C.bloco_sim[b+1]; k++) O << "    V s" << P.sinal[k] << " = {0, 0};\n";
+    O << "    for (bool mudou = true; mudou; )\n";
+    O << "    {\n";
+    O << "      mudou = false;\n";
+    for (int k=C.bloco_sim[b]; k<C.bloco_sim[b+1]; k++)
+    {
+      O << "      mudou |= M(s" << P.sinal[k] << ", ";
+      escreverExpressao(O, P, k);
+      O << ");\n";
+    }
+    O << "    }\n";
+  }
+
+  for (int j=0; j<Nout; j++) O << "    out[" << j << "*NPalavras + w] = s" << P.sinal_out[j] << ";\n";
+  O << "  }\n";
+  O << "}\n";
+  return O.str();
+}
+
+///
+/// COMPILACAO E CARGA
+///
+
+CircuitoCompilado::CircuitoCompilado(): biblioteca(nullptr), funcao(nullptr), versao(0), arquivo() {}
+
+CircuitoCompilado::~CircuitoCompilado()
+{
+#ifdef COMPILADO_POSIX
+  if (biblioteca!=nullptr) dlclose(biblioteca);
+#endif
+}
+
+#ifdef COMPILADO_POSIX
+
+// Retorna S entre aspas simples, para ser usado em um comando do shell
+static std::string aspas(const std::string& S)
+{
+  std::string R = "'";
+  for (unsigned i=0; i<S.size(); i++)
+  {
+    if (S[i]=='\'') R += "'\\''";
+    else R += S[i];
+  }
+  return R + "'";
+}
+
+// Retorna true se Arq pertence ao usuario e nao pode ser alterado por outros usuarios
+// (sem permissao de escrita para o grupo e os demais); se nao, qualquer um poderia
+// trocar as bibliotecas que sao carregadas e executadas por este processo
+static bool protegido(const struct stat& info)
+{
+  return info.st_uid==getuid() && (info.st_mode & (S_IWGRP | S_IWOTH))==0;
+}
+
+// Cria o diretorio Dir e os diretorios acima dele que nao existirem (soh com acesso
+// para o usuario)
+// Retorna false se der erro ou se Dir nao for um diretorio protegido, com o motivo em erro
+static bool criarDiretorio(const std::string& Dir, std::string& erro)
+{
+  for (size_t pos = Dir.find('/', 1); ; pos = Dir.find('/', pos+1))
+  {
+    mkdir(Dir.substr(0, pos).c_str(), 0700);
+    if (pos==std::string::npos) break;
+  }
+  struct stat info;
+  if (stat(Dir.c_str(), &info)!=0 || !S_ISDIR(info.st_mode))
+  {
+    erro = "nao foi possivel criar o diretorio " + Dir;
+    return false;
+  }
+  if (!protegido(info))
+  {
+    erro = "o diretorio " + Dir + " nao pertence ao usuario ou pode ser alterado por outros usuarios";
+    return false;
+  }
+  return true;
+}
+
+// Carrega a biblioteca Arq e procura a funcao gerada
+// Retorna false (sem a biblioteca carregada) se der erro
+static bool carregar(const std::string& Arq, void*& biblioteca,
+                     CircuitoCompilado::FuncaoSimulacao& funcao)
+{
+  struct stat info;
+  if (stat(Arq.c_str(), &info)!=0 || !S_ISREG(info.st_mode) || !protegido(info)) return false;
+  biblioteca = dlopen(Arq.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (biblioteca==nullptr) return false;
+  funcao = reinterpret_cast<CircuitoCompilado::FuncaoSimulacao>(dlsym(biblioteca, NOME_FUNCAO));
+  if (funcao==nullptr)
+  {
+    dlclose(biblioteca);
+    biblioteca = nullptr;
+    return false;
+  }
+  return true;
+}
+
+// Compila o codigo para a biblioteca Arq, atraves de arquivos temporarios no mesmo
+// diretorio (a biblioteca soh aparece com o nome final quando estah completa, de modo
+// que outro processo nunca carrega uma biblioteca pela metade)
+// Retorna false se der erro, com a saida do compilador em erro
+static bool compilarBiblioteca(const std::string& Codigo, const std::string& Compilador,
+                               const std::string& Arq, std::string& erro)
+{
+  static std::atomic<unsigned> contador(0);
+  // Arq sem a extensao .so, seguido da id do processo e de um contador
+  std::string temp = Arq.substr(0, Arq.rfind('.')) + "_" + std::to_string(getpid()) + "_" +
+                     std::to_string(contador++);
+  std::string fonte = temp + ".cpp", saida = temp + ".so", registro = temp + ".log";
+
+  {
+    std::ofstream F(fonte.c_str());
+    F << Codigo;
+    if (!F.good())
+    {
+      erro = "nao foi possivel escrever o arquivo " + fonte;
+      return false;
+    }
+  }
+
+  std::string comando = Compilador + " " + OPCOES_COMPILADOR + " -o " + aspas(saida) + " " +
+                        aspas(fonte) + " > " + aspas(registro) + " 2>&1";
+  bool ok = (std::system(comando.c_str())==0);
+  if (!ok)
+  {
+    std::ifstream R(registro.c_str());
+    std::string linha;
+    erro = "erro ao compilar (" + comando + ")";
+    for (int n=0; n<10 && std::getline(R, linha); n++) erro += "\n" + linha;
+  }
+  // Tira a permissao de escrita do grupo e dos demais que o umask possa ter deixado,
+  // pois carregar recusa bibliotecas que outros usuarios podem alterar
+  else if (chmod(saida.c_str(), 0755)!=0 || std::rename(saida.c_str(), Arq.c_str())!=0)
+  {
+    erro = "nao foi possivel criar o arquivo " + Arq;
+    ok = false;
+  }
+  std::remove(fonte.c_str());
+  std::remove(registro.c_str());
+  std::remove(saida.c_str());
+  return ok;
+}
+
+#endif // COMPILADO_POSIX
+
+std::shared_ptr<const CircuitoCompilado> CircuitoCompilado::compilar(const Circuito& C,
+                                                                     const std::string& dir_cache,
+                                                                     std::string& erro)
+{
+#ifdef COMPILADO_POSIX
+  const char* cxx = getenv("CXX");
+  std::string compilador = (cxx!=nullptr && cxx[0]!='\0' ? cxx : "c++");
+  std::string codigo = gerarCodigo(C);
+  std::string dir = (dir_cache.empty() ? diretorioCacheCompilados() : dir_cache);
+  if (dir.empty())
+  {
+    erro = "diretorio de cache indefinido (defina CIRCUITO_CACHE ou HOME)";
+    return nullptr;
+  }
+  if (!criarDiretorio(dir, erro)) return nullptr;
+
+  // O nome da biblioteca depende do codigo e da forma de compilar
+  char nome[40];
+  snprintf(nome, sizeof(nome), "/circuito3S_%016llx.so",
+           (unsigned long long)hashTexto(compilador + '\n' + OPCOES_COMPILADOR + '\n' + codigo));
+
+  std::shared_ptr<CircuitoCompilado> CC(new CircuitoCompilado);
+  CC->arquivo = dir + nome;
+  CC->versao = C.versao_sim;
+  // Se a biblioteca do cache nao puder ser carregada, compila de novo
+  if (!carregar(CC->arquivo, CC->biblioteca, CC->funcao))
+  {
+    if (!compilarBiblioteca(codigo, compilador, CC->arquivo, erro)) return nullptr;
+    if (!carregar(CC->arquivo, CC->biblioteca, CC->funcao))
+    {
+      const char* msg = dlerror();
+      erro = "nao foi possivel carregar " + CC->arquivo + (msg!=nullptr ? std::string(": ") + msg : "");
+      return nullptr;
+    }
+  }
+  return CC;
+#else
+  (void)C;
+  (void)dir_cache;
+  erro = "compilacao para codigo nativo nao suportada neste sistema";
+  return nullptr;
+#endif
+}
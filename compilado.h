@@ -0,0 +1,86 @@
+#ifndef _COMPILADO_H_
+#define _COMPILADO_H_
+
+//Autores:  Luisa de Moura Galvão Mathias
+//          Marcos Paulo Barbosa
+
+#include <memory>
+#include <string>
+#include "bool3S_64.h"
+
+class Circuito;
+
+///
+/// CIRCUITO COMPILADO PARA CODIGO NATIVO
+///
+
+// Um circuito traduzido para uma funcao C++ sem lacos sobre as portas: um comando por
+// porta, na ordem de simulacao (plana), com os valores no formato de bool3S_64 (planos
+// T e F) e as operacoes bit a bit de bool3S_64. Os blocos com realimentacao viram um
+// laco que repete os comandos das portas do bloco ateh nenhum valor mudar
+// O codigo eh compilado pelo compilador do sistema (variavel de ambiente CXX, ou c++)
+// para uma biblioteca dinamica, que eh carregada com dlopen. As bibliotecas ficam
+// guardadas em um diretorio de cache, com o hash do codigo gerado no nome, de modo que
+// o mesmo circuito soh eh compilado uma vez (inclusive por processos diferentes)
+// Soh funciona em sistemas POSIX; nos demais, compilar sempre falha
+// Normalmente eh usado atraves de Circuito::compilar, que faz simularLote e simular64
+// usarem a funcao compilada
+
+// Diretorio de cache usado quando nenhum eh informado: a variavel de ambiente
+// CIRCUITO_CACHE, ou $HOME/.cache/circuito3S, ou "" se nenhuma das duas existir (nao
+// ha diretorio comum a todos os usuarios, como /tmp, pois outro usuario poderia
+// colocar lah as bibliotecas que seriam carregadas)
+std::string diretorioCacheCompilados();
+
+class CircuitoCompilado {
+public:
+  // A funcao gerada: simula NPalavras palavras (64 combinacoes de entrada cada), com as
+  // entradas e as saidas no formato de Circuito::simularLote
+  typedef void (*FuncaoSimulacao)(const void* in_circ, void* out_lote, int NPalavras);
+
+  // Nao pode ser copiado (a biblioteca eh descarregada no destrutor)
+  CircuitoCompilado(const CircuitoCompilado&) = delete;
+  void operator=(const CircuitoCompilado&) = delete;
+  // Destrutor: descarrega a biblioteca
+  ~CircuitoCompilado();
+
+  // Retorna o codigo C++ da funcao que simula o circuito C
+  // A ordem de simulacao de C jah deve estar calculada (prepararSimulacao)
+  static std::string gerarCodigo(const Circuito& C);
+
+  // Gera o codigo do circuito C (valido, com a ordem calculada), compila-o no diretorio
+  // dir_cache ("" para diretorioCacheCompilados), se a biblioteca ainda nao estiver lah,
+  // e carrega a biblioteca
+  // O diretorio e a biblioteca devem pertencer ao usuario e nao podem ter permissao de
+  // escrita para o grupo ou os demais usuarios (uma biblioteca nessas condicoes eh
+  // compilada de novo; um diretorio eh um erro)
+  // Retorna nullptr em caso de erro, com a descricao do erro em erro
+  static std::shared_ptr<const CircuitoCompilado> compilar(const Circuito& C,
+                                                           const std::string& dir_cache,
+                                                           std::string& erro);
+
+  // Simula NPalavras palavras: in_circ tem Nin*NPalavras elementos e out_lote tem
+  // Nout*NPalavras elementos, no formato de Circuito::simularLote
+  // Pode ser chamada ao mesmo tempo por varias threads
+  void simularLote(const bool3S_64* in_circ, int NPalavras, bool3S_64* out_lote) const
+  {
+    funcao(in_circ, out_lote, NPalavras);
+  }
+
+  // A versao do circuito (Circuito::versao_sim) que foi compilada
+  unsigned long getVersao() const { return versao; }
+  // O arquivo da biblioteca carregada
+  const std::string& getArquivo() const { return arquivo; }
+
+private:
+  // O resultado de dlopen e a funcao gerada
+  void* biblioteca;
+  FuncaoSimulacao funcao;
+  unsigned long versao;
+  std::string arquivo;
+
+  // Soh eh criado por compilar
+  CircuitoCompilado();
+};
+
+#endif // _COMPILADO_H_
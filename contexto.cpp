@@ -0,0 +1,52 @@
+#include "contexto.h"
+
+//Autores:  Luisa de Moura Galvão Mathias
+//          Marcos Paulo Barbosa
+
+///
+/// CLASSE CONTEXTO DE SIMULACAO
+///
+
+ContextoSimulacao::ContextoSimulacao(): num_entradas(0), val_sinal(), out_circ(), val_sinal64(),
+  out_circ64(), val_bloco(), versao_estado(0), fila_blocos(), bloco_na_fila(), anterior_bloco() {}
+
+// Libera a memoria de todos os vetores e descarta o estado da simulacao incremental
+void ContextoSimulacao::clear()
+{
+  num_entradas = 0;
+  val_sinal.clear();
+  val_sinal.shrink_to_fit();
+  out_circ.clear();
+  out_circ.shrink_to_fit();
+  val_sinal64.clear();
+  val_sinal64.shrink_to_fit();
+  out_circ64.clear();
+  out_circ64.shrink_to_fit();
+  val_bloco.clear();
+  val_bloco.shrink_to_fit();
+  versao_estado = 0;
+  fila_blocos.clear();
+  fila_blocos.shrink_to_fit();
+  bloco_na_fila.clear();
+  bloco_na_fila.shrink_to_fit();
+  anterior_bloco.clear();
+  anterior_bloco.shrink_to_fit();
+}
+
+bool3S ContextoSimulacao::getOutput(int IdOutput) const
+{
+  if (IdOutput>=1 && IdOutput<=int(out_circ.size())) return out_circ[IdOutput-1];
+  return bool3S::UNDEF;
+}
+
+bool3S ContextoSimulacao::getOutputPort(int IdPort) const
+{
+  if (IdPort>=1 && num_entradas+IdPort<=int(val_sinal.size())) return val_sinal[num_entradas+IdPort-1];
+  return bool3S::UNDEF;
+}
+
+bool3S_64 ContextoSimulacao::getOutput64(int IdOutput) const
+{
+  if (IdOutput>=1 && IdOutput<=int(out_circ64.size())) return out_circ64[IdOutput-1];
+  return toBool3S_64(bool3S::UNDEF);
+}
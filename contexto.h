@@ -0,0 +1,93 @@
+#ifndef _CONTEXTO_H_
+#define _CONTEXTO_H_
+
+//Autores:  Luisa de Moura Galvão Mathias
+//          Marcos Paulo Barbosa
+
+#include <cstdint>
+#include <vector>
+#include "bool3S.h"
+#include "bool3S_64.h"
+
+class Circuito;
+
+///
+/// CLASSE CONTEXTO DE SIMULACAO
+///
+
+// Guarda os valores dos sinais de uma simulacao de um Circuito
+// O Circuito (portas e ligacoes) nao eh alterado pelos metodos de simulacao que recebem
+// um ContextoSimulacao, de modo que varias threads podem simular o mesmo Circuito ao
+// mesmo tempo, sem copias e sem travas, desde que cada uma use o seu proprio contexto
+// Os vetores sao dimensionados pelo Circuito na primeira simulacao (ou antes, por
+// Circuito::prepararContexto) e reaproveitados nas seguintes, que nao alocam memoria;
+// um contexto pode ser usado com circuitos diferentes
+
+class ContextoSimulacao {
+  friend class Circuito;
+
+private:
+  /// ***********************
+  /// Dados
+  /// ***********************
+
+  // Numero de entradas do circuito simulado (indice do sinal da primeira porta)
+  int num_entradas;
+
+  // Os valores logicos de todos os sinais, na ordem de NetlistPlana: as entradas do
+  // circuito seguidas pelas saidas das portas (val_sinal[num_entradas+IdPort-1]) (simular)
+  std::vector<bool3S> val_sinal;
+  // Os valores logicos das saidas do circuito: out_circ[IdOutput-1] (simular)
+  std::vector<bool3S> out_circ;
+
+  // Idem para a simulacao de 64 combinacoes de entrada ao mesmo tempo (simular64)
+  std::vector<bool3S_64> val_sinal64;
+  std::vector<bool3S_64> out_circ64;
+
+  // Os valores de todos os sinais durante a simulacao em blocos (simularLote):
+  // o sinal s ocupa as palavras s*TAMANHO_BLOCO a (s+1)*TAMANHO_BLOCO-1
+  // Ha um bloco a mais no final para uso temporario
+  std::vector<uint64_t> val_bloco;
+
+  // Estado usado pela simulacao incremental (simularIncremental)
+  // A versao do circuito (Circuito::versao_sim) a que val_sinal corresponde, ou 0 se
+  // nao ha estado anterior (val_sinal guarda tambem as entradas da ultima simulacao)
+  unsigned long versao_estado;
+  // Os blocos de simulacao que precisam ser resimulados, em um heap com o menor
+  // indice de bloco no topo, e a marca dos blocos que jah estao no heap
+  std::vector<int> fila_blocos;
+  std::vector<char> bloco_na_fila;
+  // Os valores anteriores das portas de um bloco com realimentacao
+  std::vector<bool3S> anterior_bloco;
+
+public:
+  /// ***********************
+  /// Inicializacao e finalizacao
+  /// ***********************
+
+  // Cria um contexto vazio (dimensionado na primeira simulacao)
+  ContextoSimulacao();
+
+  // Libera a memoria de todos os vetores e descarta o estado da simulacao incremental
+  void clear();
+
+  /// ***********************
+  /// Funcoes de consulta
+  /// ***********************
+
+  // Retorna o valor logico da saida do circuito cuja id eh IdOutput, calculado pela
+  // ultima simulacao com simular ou simularIncremental, ou bool3S::UNDEF se IdOutput
+  // for invalido
+  bool3S getOutput(int IdOutput) const;
+
+  // Retorna o valor logico da saida da porta cuja id eh IdPort, calculado pela
+  // ultima simulacao com simular ou simularIncremental, ou bool3S::UNDEF se IdPort
+  // for invalido
+  bool3S getOutputPort(int IdPort) const;
+
+  // Retorna os valores logicos da saida do circuito cuja id eh IdOutput, calculados pela
+  // ultima simulacao com simular64, ou tudo bool3S::UNDEF se IdOutput for invalido
+  bool3S_64 getOutput64(int IdOutput) const;
+};
+
+#endif // _CONTEXTO_H_
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <atomic>
+#include "exportar.h"
+#include "tabela.h"
+
+//Autores:  Luisa de Moura Galvão Mathias
+//          Marcos Paulo Barbosa
+
+///
+/// ESCRITOR COM BUFFER
+///
+
+EscritorBuffer::EscritorBuffer(): arq(nullptr), proprio(false), buffer(), usado(0), falhou(false) {}
+
+EscritorBuffer::~EscritorBuffer()
+{
+  fechar();
+}
+
+bool EscritorBuffer::abrir(const std::string& Nome)
+{
+  fechar();
+  falhou = false;
+  if (Nome=="-")
+  {
+    arq = stdout;
+    proprio = false;
+  }
+  else
+  {
+    arq = fopen(Nome.c_str(), "wb");
+    proprio = true;
+  }
+  if (arq==nullptr) return false;
+  buffer.resize(TAMANHO_BUFFER_ESCRITA);
+  usado = 0;
+  return true;
+}
+
+bool EscritorBuffer::fechar()
+{
+  if (arq==nullptr) return ok();
+  esvaziar();
+  if (proprio)
+  {
+    if (fclose(arq)!=0) falhou = true;
+  }
+  else if (fflush(arq)!=0) falhou = true;
+  arq = nullptr;
+  buffer.clear();
+  buffer.shrink_to_fit();
+  return ok();
+}
+
+void EscritorBuffer::esvaziar()
+{
+  if (usado>0 && fwrite(buffer.data(), 1, usado, arq)!=usado) falhou = true;
+  usado = 0;
+}
+
+void EscritorBuffer::escrever(const char* Dados, size_t N)
+{
+  // Blocos maiores que o buffer vao direto para o arquivo
+  if (usado+N>buffer.size())
+  {
+    esvaziar();
+    if (N>=buffer.size())
+    {
+      if (fwrite(Dados, 1, N, arq)!=N) falhou = true;
+      return;
+    }
+  }
+  std::copy(Dados, Dados+N, &buffer[usado]);
+  usado += N;
+}
+
+void EscritorBuffer::escreverNumero(uint64_t N)
+{
+  char digitos[20];
+  int n = 0;
+  do
+  {
+    digitos[n++] = '0' + N%10;
+    N /= 10;
+  } while (N>0);
+  while (n>0) escrever(digitos[--n]);
+}
+
+///
+/// EXPORTACAO DA TABELA VERDADE
+///
+
+// Monta o modelo de uma linha do formato TEXTO (com os separadores jah nos lugares) e
+// as posicoes em que vao os valores das entradas e das saidas
+static std::string modeloLinhaTexto(int Nin, int Nout, std::vector<int>& pos_in,
+                                    std::vector<int>& pos_out)
+{
+  std::string linha;
+  for (int i=0; i<Nin; i++)
+  {
+    pos_in.push_back(linha.size());
+    linha += '?';
+    if (i<Nin-1) linha += ' ';
+    else
+    {
+      linha += '\t';
+      if (Nin<=2) linha += '\t';
+    }
+  }
+  for (int j=0; j<Nout; j++)
+  {
+    pos_out.push_back(linha.size());
+    linha += '?';
+    linha += (j<Nout-1 ? ' ' : '\n');
+  }
+  return linha;
+}
+
+bool exportarTabela(const Circuito& C, const std::string& Arq, FormatoTabela F,
+                    uint64_t inicio, uint64_t fim, int Nthreads)
+{
+  const int Nin = C.getNumInputs();
+  const int Nout = C.getNumOutputs();
+  // Sem linhas (entradas demais para uma tabela), nada eh escrito, nem o cabecalho
+  if (!C.prepararSimulacao() || numLinhasTabela(Nin)==0) return false;
+  if (inicio>fim || fim>numLinhasTabela(Nin)) return false;
+  if (F==FormatoTabela::CUBOS && (inicio!=0 || fim!=numLinhasTabela(Nin))) return false;
+
+  EscritorBuffer E;
+  if (!E.abrir(Arq)) return false;
+
+  // Os caracteres dos valores UNDEF, FALSE e TRUE
+  const char simbolo[3] = {toChar(bool3S::UNDEF), toChar(bool3S::FALSE), toChar(bool3S::TRUE)};
+  std::vector<int> pos_in, pos_out;
+  std::string linha;
+  const uint32_t bytes_linha = (Nout+3)/4;
+  std::vector<uint8_t> bytes(bytes_linha);
+
+  // Cabecalho
+  switch (F)
+  {
+  case FormatoTabela::TEXTO:
+  case FormatoTabela::CUBOS:
+    if (inicio==0) E.escrever("ENTRADAS\tSAIDAS\n");
+    linha = modeloLinhaTexto(Nin, Nout, pos_in, pos_out);
+    break;
+  case FormatoTabela::CSV:
+    if (inicio==0)
+    {
+      E.escrever("LINHA");
+      for (int i=0; i<Nin; i++)
+      {
+        E.escrever(",E");
+        E.escreverNumero(i+1);
+      }
+      for (int j=0; j<Nout; j++)
+      {
+        E.escrever(",S");
+        E.escreverNumero(j+1);
+      }
+      E.escrever('\n');
+    }
+    // Cada valor eh precedido por uma virgula
+    for (int i=0; i<Nin+Nout; i++)
+    {
+      linha += ',';
+      (i<Nin ? pos_in : pos_out).push_back(linha.size());
+      linha += '?';
+    }
+    linha += '\n';
+    break;
+  case FormatoTabela::BINARIO:
+    {
+      CabecalhoTabela Cab = {{'T','A','B','3','S','\0','\0','\0'}, VERSAO_TABELA,
+                             uint32_t(Nin), uint32_t(Nout), bytes_linha, inicio, fim};
+      E.escrever(reinterpret_cast<const char*>(&Cab), sizeof(Cab));
+    }
+    break;
+  }
+
+  if (F==FormatoTabela::CUBOS)
+  {
+    bool cubos_OK = gerarCubos(C, [&](const CuboTabela& Cubo)
+    {
+      for (int i=0; i<Nin; i++) linha[pos_in[i]] = (Cubo.livre[i] ? '-' : simbolo[int(Cubo.in_circ[i])]);
+      for (int j=0; j<Nout; j++) linha[pos_out[j]] = simbolo[int(Cubo.out_circ[j])];
+      E.escrever(linha);
+    });
+    return E.fechar() && cubos_OK;
+  }
+
+  // Um erro de escrita cancela a geracao, para nao simular o resto da tabela em vao
+  std::atomic<bool> erro_escrita(false);
+  bool tabela_OK = gerarTabelaParalela(C, inicio, fim, [&](const TrechoTabela& T)
+  {
+    for (int k=0; k<T.num_linhas; k++)
+    {
+      if (F==FormatoTabela::BINARIO)
+      {
+        std::fill(bytes.begin(), bytes.end(), 0);
+        for (int j=0; j<Nout; j++) bytes[j/4] |= uint8_t(T.saida(k,j)) << (2*(j%4));
+        E.escrever(reinterpret_cast<const char*>(bytes.data()), bytes_linha);
+        continue;
+      }
+      for (int i=0; i<Nin; i++) linha[pos_in[i]] = simbolo[int(T.entrada(k,i))];
+      for (int j=0; j<Nout; j++) linha[pos_out[j]] = simbolo[int(T.saida(k,j))];
+      if (F==FormatoTabela::CSV) E.escreverNumero(T.inicio+k);
+      E.escrever(linha);
+    }
+    if (!E.ok()) erro_escrita = true;
+  }, Nthreads, &erro_escrita);
+
+  return E.fechar() && tabela_OK;
+}
@@ -0,0 +1,125 @@
+#ifndef _EXPORTAR_H_
+#define _EXPORTAR_H_
+
+//Autores:  Luisa de Moura Galvão Mathias
+//          Marcos Paulo Barbosa
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "circuito.h"
+
+///
+/// ESCRITOR COM BUFFER
+///
+
+// Escreve em um arquivo (ou na saida padrao) atraves de um buffer grande, de modo que
+// o sistema soh eh chamado a cada TAMANHO_BUFFER_ESCRITA bytes, e nao a cada valor
+// escrito como nas impressoes com cout
+
+const size_t TAMANHO_BUFFER_ESCRITA = 1<<20;
+
+class EscritorBuffer {
+private:
+  // O arquivo aberto, e se ele deve ser fechado (false para a saida padrao)
+  FILE* arq;
+  bool proprio;
+  // Os bytes ainda nao enviados ao arquivo: buffer[0] a buffer[usado-1]
+  std::vector<char> buffer;
+  size_t usado;
+  // true se alguma escrita falhou
+  bool falhou;
+
+  // Envia o conteudo do buffer para o arquivo
+  void esvaziar();
+
+public:
+  EscritorBuffer();
+  // Nao pode ser copiado (o arquivo eh fechado no destrutor)
+  EscritorBuffer(const EscritorBuffer&) = delete;
+  void operator=(const EscritorBuffer&) = delete;
+  // Destrutor: apenas chama a funcao fechar()
+  ~EscritorBuffer();
+
+  // Abre para escrita (binaria) o arquivo de nome Nome, ou usa a saida padrao se
+  // Nome for "-" (fechando o anterior)
+  // Retorna true se deu tudo OK; false se deu erro
+  bool abrir(const std::string& Nome);
+  // Esvazia o buffer e fecha o arquivo
+  // Retorna true se todas as escritas deram certo
+  bool fechar();
+
+  // Escreve um caractere, ou N bytes a partir de Dados
+  void escrever(char C)
+  {
+    if (usado==buffer.size()) esvaziar();
+    buffer[usado++] = C;
+  }
+  void escrever(const char* Dados, size_t N);
+  void escrever(const std::string& S) { escrever(S.data(), S.size()); }
+  // Escreve um numero inteiro em decimal
+  void escreverNumero(uint64_t N);
+
+  // Retorna true se nenhuma escrita falhou ateh agora
+  bool ok() const { return !falhou; }
+};
+
+///
+/// EXPORTACAO DA TABELA VERDADE
+///
+
+// Formatos em que a tabela verdade pode ser exportada
+enum class FormatoTabela {
+  // O mesmo formato da tabela impressa na tela: o cabecalho "ENTRADAS<tab>SAIDAS" e
+  // uma linha de texto por linha da tabela, com os valores ? F T separados por espacos
+  // e as entradas separadas das saidas por tabulacao
+  TEXTO,
+  // Valores separados por virgula: o cabecalho LINHA,E1,...,ENin,S1,...,SNout e uma
+  // linha de texto por linha da tabela, com o indice da linha e os valores ? F T
+  // (Ei eh a entrada de id -i e Sj eh a saida de id j)
+  CSV,
+  // Binario compacto: o cabecalho CabecalhoTabela seguido, para cada linha da tabela,
+  // dos valores das saidas com 2 bits cada (0=UNDEF, 1=FALSE, 2=TRUE), a saida j+1 nos
+  // bits 2*(j%4) e 2*(j%4)+1 do byte j/4 da linha. Cada linha ocupa (Nout+3)/4 bytes
+  // As entradas nao sao gravadas: sao os digitos do indice da linha (entradaLinha)
+  BINARIO,
+  // Cubos (gerarCubos): o mesmo formato de TEXTO, mas cada linha de texto eh um cubo, com
+  // '-' no lugar das entradas que podem ter qualquer valor (o '?' continua sendo UNDEF)
+  // O '-' pode aparecer em qualquer entrada, e os cubos saem na ordem de gerarCubos (nao
+  // necessariamente a ordem das linhas)
+  // Soh pode ser usado para a tabela inteira (inicio==0 e fim==3^Nin)
+  CUBOS
+};
+
+// Cabecalho do formato FormatoTabela::BINARIO (numeros na ordem de bytes da maquina)
+struct CabecalhoTabela {
+  // "TAB3S" seguido de tres bytes 0
+  char assinatura[8];
+  // VERSAO_TABELA
+  uint32_t versao;
+  // Numero de entradas e de saidas do circuito
+  uint32_t Nin, Nout;
+  // Numero de bytes de cada linha
+  uint32_t bytes_linha;
+  // As linhas gravadas sao as de inicio a fim-1
+  uint64_t inicio, fim;
+};
+
+// A versao atual do formato binario da tabela
+const uint32_t VERSAO_TABELA = 1;
+
+// Escreve em Arq ("-" para a saida padrao) as linhas de inicio a fim-1 da tabela verdade
+// do circuito C no formato F. As linhas sao simuladas em paralelo por gerarTabelaParalela
+// (com Nthreads threads) e escritas em ordem, trecho a trecho, por um EscritorBuffer,
+// de modo que a tabela inteira nunca fica na memoria
+// Os cabecalhos de TEXTO e CSV soh sao escritos quando inicio==0, para que uma tabela
+// gerada em pedacos (inicio e fim consecutivos) possa ser juntada concatenando os arquivos
+// No formato CUBOS, a tabela eh gerada por gerarCubos (em uma soh thread)
+// Um erro na escrita cancela a simulacao dos trechos seguintes
+// Retorna true se deu tudo OK; false se o circuito ou o intervalo forem invalidos, se o
+// circuito tiver mais de MAX_ENTRADAS_TABELA entradas ou se deu erro na escrita
+bool exportarTabela(const Circuito& C, const std::string& Arq, FormatoTabela F,
+                    uint64_t inicio, uint64_t fim, int Nthreads=0);
+
+#endif // _EXPORTAR_H_
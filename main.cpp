@@ -1,5 +1,6 @@
 #include "maincircuito.h"
 #include <QApplication>
+#include "circuitoconst.h" // o compilador confere o circuito de exemplo (static_assert)
 
 //Autores:  Luisa de Moura Galvão Mathias
 //          Marcos Paulo Barbosa
@@ -6,12 +6,14 @@
 #include <QStringList>
 #include <QString>
 #include <QFileDialog>
+#include <QHeaderView>
 #include <QMessageBox>
-#include <cmath>
 #include <vector>
 #include <string>
 #include "bool3S.h"
 #include "circuito.h"
+#include "modelotabela.h"
+#include "tabela.h"
 
 //Autores:  Luisa de Moura Galvo Mathias
 //          Marcos Paulo Barbosa
@@ -21,13 +23,20 @@ MainCircuito::MainCircuito(QWidget *parent) : QMainWindow(parent)
 ,numIn(new QLabel(this))
 ,numOut(new QLabel(this))
 ,numPortas(new QLabel(this))
+,progresso(new QProgressBar(this))
 ,newCircuito(new NewCircuito(this))
 ,modificarPorta(new ModificarPorta(this))
 ,modificarSaida(new ModificarSaida(this))
 ,C(new Circuito())
+,modeloTabela(new ModeloTabela(C, this))
 {
   ui->setupUi(this);
 
+  // A tabela verdade eh exibida a partir do modelo, que soh simula as linhas visiveis
+  // Com altura fixa, as linhas nao precisam ser medidas, mesmo em tabelas enormes
+  ui->tableTabelaVerdade->setModel(modeloTabela);
+  ui->tableTabelaVerdade->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+
   // Cabecalhos da tabela de portas
   ui->tablePortas->horizontalHeader()->setVisible(true);
   ui->tablePortas->verticalHeader()->setVisible(true);
@@ -42,8 +51,19 @@ MainCircuito::MainCircuito(QWidget *parent) : QMainWindow(parent)
   statusBar()->insertWidget(3,numOut);
   statusBar()->insertWidget(4,new QLabel("   Num portas: "));
   statusBar()->insertWidget(5,numPortas);
+  // A barra de progresso soh aparece durante a geracao da tabela verdade
+  progresso->setRange(0,100);
+  progresso->setMaximumWidth(150);
+  progresso->hide();
+  statusBar()->insertWidget(6,progresso);
 
   // Conecta sinais
+  // Sinais do modelo da tabela verdade (geracao em segundo plano) para janela principal
+  connect(modeloTabela, &ModeloTabela::signProgresso,
+          progresso, &QProgressBar::setValue);
+  connect(modeloTabela, &ModeloTabela::signFimGeracao,
+          this, &MainCircuito::slotFimGeracao);
+
   // Sinais da janela principal para janela novo circuito
   connect(this, &MainCircuito::signShowNewCircuito,
           newCircuito, &NewCircuito::slotShowNewCircuito);
@@ -84,6 +104,8 @@ MainCircuito::~MainCircuito()
 
 void MainCircuito::slotNewCircuito(int NInputs, int NOutputs, int NPortas)
 {
+  // O circuito nao pode ser alterado durante a geracao da tabela verdade
+  modeloTabela->parar();
   // O circuito deve ser criado usando a funcao apropriada da classe Circuito
   C->resize(NInputs, NOutputs, NPortas);
   // Depois do novo circuito criado, as tabelas devem ser redimensionadas
@@ -93,6 +115,9 @@ void MainCircuito::slotNewCircuito(int NInputs, int NOutputs, int NPortas)
 void MainCircuito::slotModificarPorta(int IdPort, QString TipoPort, int NumInputsPort,
                                       int IdInput0, int IdInput1, int IdInput2, int IdInput3)
 {
+  // O circuito nao pode ser alterado durante a geracao da tabela verdade
+  modeloTabela->parar();
+
   // Aqui deve ser chamado um metodo da classe Circuito que altere a porta cuja
   // id eh IdPort para que ela assuma as caracteristicas especificadas por
   // TipoPort, NumInputsPort
@@ -106,6 +131,10 @@ void MainCircuito::slotModificarPorta(int IdPort, QString TipoPort, int NumInput
   if (NumInputsPort>2) C->setId_inPort(IdPort, 2, IdInput2);
   if (NumInputsPort>3) C->setId_inPort(IdPort, 3, IdInput3);
 
+  // Refaz a ordem de simulacao e o bytecode do circuito alterado (leva poucos
+  // milissegundos), para a proxima tabela verdade jah comecar simulando
+  C->prepararSimulacao();
+
   // Depois de alterada, deve ser reexibida a porta correspondente e limpa a tabela verdade
   showPort(IdPort-1);
   limparTabelaVerdade();
@@ -113,6 +142,9 @@ void MainCircuito::slotModificarPorta(int IdPort, QString TipoPort, int NumInput
 
 void MainCircuito::slotModificarSaida(int IdSaida, int IdOrigemSaida)
 {
+  // O circuito nao pode ser alterado durante a geracao da tabela verdade
+  modeloTabela->parar();
+
   // Aqui deve ser chamado um metodo da classe Circuito que altere a saida cuja
   // id eh IdSaida para que ela assuma a origem especificada por
   // IdOrigemSaida
@@ -136,7 +168,6 @@ void MainCircuito::redimensionaTabelas()
 
   // Variaveis auxiliares
   //QString texto;
-  QLabel *prov;
   int i;
 
   // ==========================================================
@@ -177,39 +208,9 @@ void MainCircuito::redimensionaTabelas()
   // Redimensiona a tabela verdade
   // ==========================================================
 
-  // Antes de redimensionar a tabela, anula todos os setSpan da primeira linha
-  // Se nao fizer isso, dah erro ao redimensionar
-  ui->tableTabelaVerdade->clearSpans();
-
-  // Limpa todo o conteudo, inclusive cabecalhos
-  ui->tableTabelaVerdade->clear();
-
-  // Modifica as dimensoes
-  ui->tableTabelaVerdade->setColumnCount(numInputs+numOutputs);
-  int numCombinacoesEntrada = (numInputs>0 ? round(pow(3,numInputs)) : 0);
-  // a tabela verdade tem uma linha a mais do que o numero de combinacoes de entrada
-  // para conter o pseudocabecalho
-  ui->tableTabelaVerdade->setRowCount(1 + numCombinacoesEntrada);
-
-  // Cria o pseudocabecalho na primeira linha
-  // Entradas
-  if (numInputs > 0)
-  {
-    ui->tableTabelaVerdade->setSpan(0,0,1,numInputs);
-    prov = new QLabel("ENTRADAS");
-    prov->setAlignment(Qt::AlignCenter);
-    prov->setStyleSheet("font-weight: bold");
-    ui->tableTabelaVerdade->setCellWidget(0,0,prov);
-  }
-  // Saidas
-  if (numOutputs > 0)
-  {
-    ui->tableTabelaVerdade->setSpan(0,numInputs,1,numOutputs);
-    prov = new QLabel("SAIDAS");
-    prov->setAlignment(Qt::AlignCenter);
-    prov->setStyleSheet("font-weight: bold");
-    ui->tableTabelaVerdade->setCellWidget(0,numInputs,prov);
-  }
+  // O modelo passa a ter uma coluna para cada entrada e saida e uma linha para cada
+  // combinacao de entrada, todas vazias ateh que a tabela seja gerada
+  modeloTabela->limpar();
 
   // ==========================================================
   // Fixa os limites para os spin boxs (emit signSetRangeInputs)
@@ -307,36 +308,8 @@ void MainCircuito::showOutput(unsigned i)
 // Deve ser chamada sempre que alguma caracteristica do circuito (porta, saida) for alterada
 void MainCircuito::limparTabelaVerdade()
 {
-  // Esses valores (numInputs, numOutputs)
-  // devem ser lidos a partir de metodos de consulta da classe Circuito
-  // Provisoriamente, estao sendo inicializados com valores nulos
-
-  int numInputs=C->getNumInputs();
-  int numOutputs=C->getNumOutputs();
-
-  // Variavel auxiliar
-  QLabel *prov;
-
-  // Limpa todo o conteudo, inclusive cabecalhos
-  ui->tableTabelaVerdade->clear();
-
-  // Recoloca os textos dos cabecalhos na primeira linha
-  // Entradas
-  if (numInputs > 0)
-  {
-    prov = new QLabel("ENTRADAS");
-    prov->setAlignment(Qt::AlignCenter);
-    prov->setStyleSheet("font-weight: bold");
-    ui->tableTabelaVerdade->setCellWidget(0,0,prov);
-  }
-  // Saidas
-  if (numOutputs > 0)
-  {
-    prov = new QLabel("SAIDAS");
-    prov->setAlignment(Qt::AlignCenter);
-    prov->setStyleSheet("font-weight: bold");
-    ui->tableTabelaVerdade->setCellWidget(0,numInputs,prov);
-  }
+  // O modelo descarta os valores; as dimensoes continuam as do circuito
+  modeloTabela->limpar();
 }
 
 void MainCircuito::on_actionSair_triggered()
@@ -357,6 +330,9 @@ void MainCircuito::on_actionLer_triggered()
                                                   tr("Circuitos (*.txt);;Todos (*.*)"));
 
   if (!fileName.isEmpty()) {
+    // O circuito nao pode ser alterado durante a geracao da tabela verdade
+    modeloTabela->parar();
+
     // Leh o circuito do arquivo com nome "fileName", usando a funcao apropriada da classe Circuito
     // e testa se a leitura deu certo
     // Provisoriamente, o teste eh sempre falso
@@ -366,7 +342,8 @@ void MainCircuito::on_actionLer_triggered()
     {
       // Exibe uma msg de erro na leitura
       QMessageBox msgBox;
-      msgBox.setText("Erro ao ler um circuito a partir do arquivo:\n"+fileName);
+      msgBox.setText("Erro ao ler um circuito a partir do arquivo:\n"+fileName+"\n"+
+                     QString::fromStdString(C->getErroLeitura()));
       msgBox.exec();
     }
 
@@ -409,7 +386,7 @@ void MainCircuito::on_actionSalvar_triggered()
 }
 
 // Gera e exibe a tabela verdade para o circuito
-// Chama a funcao simular da classe circuito
+// As linhas sao simuladas pelo modelo (ModeloTabela) aa medida que sao exibidas
 void MainCircuito::on_actionGerar_tabela_triggered()
 {
   // Soh pode simular se o Circuito for valido
@@ -424,74 +401,31 @@ void MainCircuito::on_actionGerar_tabela_triggered()
     return;
   }
 
-  // Cria e inicializa o vetor de entradas do circuito //
-
-  // Esses valores (numInputs, numOutputs)
-  // devem ser lidos a partir de metodos de consulta da classe Circuito
-  // Provisoriamente, estao sendo inicializados com valores nulos
-
-  int numInputs= C->getNumInputs();
-  int numOutputs= C->getNumOutputs();
-  // Calcula o numero de combinacoes de entrada
-  int numCombinacoesEntrada = (numInputs>0 ? round(pow(3,numInputs)) : 0);
-
-  // As entradas do circuito
-  std::vector<bool3S> in_circ(numInputs);    // bool3S::UNDEF; bool3S::FALSE; bool3S::TRUE
-
-  // Variaveis auxiliares
-  QLabel *prov;
-  int i,j;
-
-  // Inicializa todas as entradas com bool3S::UNDEF
-  for (i=0; i<numInputs; i++) in_circ[i] = bool3S::UNDEF;
-
-  // Gera todas as combinacoes de entrada e as linhas correspondentes da tabela verdade //
-  for (i=0; i<numCombinacoesEntrada; i++)
+  // As linhas nao sao simuladas aqui: o modelo gera a tabela em segundo plano, //
+  // publicando as linhas aos poucos, e simula na hora as linhas exibidas que ainda //
+  // nao ficaram prontas //
+  if (modeloTabela->gerando()) return;
+  modeloTabela->gerar();
+  if (modeloTabela->gerando())
   {
-    // Exibe a i-esima combinao de entrada //
-
-    // Cria os QLabels correspondentes aas entradas in_circ[j]
-    for (j=0; j<numInputs; j++)
-    {
-      prov = new QLabel( QString( toChar(in_circ[j]) ) );
-      prov->setAlignment(Qt::AlignCenter);
-      ui->tableTabelaVerdade->setCellWidget(i+1, j, prov);
-    }
-
-    // Simula a saida para a i-esima combinacao de entrada //
-
-    // Chama o metodo de simulacao da classe Circuito //
-
-    C->simular(in_circ);
-
-    // Exibe a saida correspondente aa i-esima combinacao de entrada //
-
-    // Cria os QLabels correspondentes aas saidas outputs[j]
-
-    for (j=0; j<numOutputs; j++)
-    {
-      // A saida deve ser obtida com um metodo de consulta da classe Circuito
-      // Provisoriamente, estah sendo inicializada sempre com valor UNDEF
-      bool3S output = C->getOutput(j);
-      prov = new QLabel( QString( toChar(output) ) );
-      prov->setAlignment(Qt::AlignCenter);
-      ui->tableTabelaVerdade->setCellWidget(i+1, j+numInputs, prov);
-    }
-
-    // Gera a proxima combinacao de entrada
-
-    // Incrementa a ultima entrada que nao for TRUE
-    // Se a ultima for TRUE, faz essa ser UNDEF e tenta incrementar a anterior
-    j = numInputs-1;
-    while (in_circ[j]==bool3S::TRUE && j>=0)
-    {
-      in_circ[j] = bool3S::UNDEF;
-      j--;
-    };
-    // Incrementa a input selecionada
-    if (j>=0) in_circ[j]++;
+    progresso->setValue(0);
+    progresso->show();
+    ui->actionCancelar_tabela->setEnabled(true);
   }
+}
 
+// Cancela a geracao da tabela verdade em segundo plano
+void MainCircuito::on_actionCancelar_tabela_triggered()
+{
+  modeloTabela->parar();
+}
+
+// Fim da geracao da tabela verdade em segundo plano
+void MainCircuito::slotFimGeracao(bool completa)
+{
+  progresso->hide();
+  ui->actionCancelar_tabela->setEnabled(false);
+  if (!completa) statusBar()->showMessage("Geracao da tabela cancelada", 3000);
 }
 
 // Exibe a caixa de dialogo para fixar caracteristicas de uma porta
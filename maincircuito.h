@@ -6,10 +6,12 @@
 
 #include <QMainWindow>
 #include <QLabel>
+#include <QProgressBar>
 #include "newcircuito.h"
 #include "modificarporta.h"
 #include "modificarsaida.h"
 #include "circuito.h"
+#include "modelotabela.h"
 
 /* ======================================================================== *
  * ESSA EH A CLASSE QUE REPRESENTA A TELA PRINCIPAL DO APLICATIVO           *
@@ -51,9 +53,17 @@ private slots:
   void on_actionSalvar_triggered();
 
   // Gera e exibe a tabela verdade para o circuito
-  // Chama a funcao simular da classe circuito
+  // As linhas sao simuladas pelo modelo (ModeloTabela) aa medida que sao exibidas
   void on_actionGerar_tabela_triggered();
 
+  // Cancela a geracao da tabela verdade em segundo plano
+  // As linhas que faltam passam a ser simuladas quando forem exibidas
+  void on_actionCancelar_tabela_triggered();
+
+  // Fim da geracao da tabela verdade em segundo plano (completa ou cancelada)
+  // Esconde a barra de progresso
+  void slotFimGeracao(bool completa);
+
   // Exibe a caixa de dialogo para fixar caracteristicas de uma porta
   void on_tablePortas_activated(const QModelIndex &index);
 
@@ -80,6 +90,7 @@ private:
   QLabel *numIn;     // Exibe o numero de entradas do circuito na barra de status
   QLabel *numOut;    // Exibe o numero de saidas do circuito na barra de status
   QLabel *numPortas; // Exibe o numero de portas do circuito na barra de status
+  QProgressBar *progresso; // Exibe o andamento da geracao da tabela verdade
 
   // As caixas pop up para digitacao de valores do circuito
   NewCircuito *newCircuito;        // Caixa de dialogo para criar um novo circuito
@@ -87,6 +98,9 @@ private:
   ModificarSaida *modificarSaida;  // Caixa de dialogo para modificar uma saida
   Circuito *C;
 
+  // O modelo da tabela verdade exibida em tableTabelaVerdade
+  ModeloTabela *modeloTabela;
+
   // Redimensiona todas as tabelas e reexibe todos os valores da barra de status
   // Essa funcao deve ser chamada sempre que mudar o circuito (digitar ou ler de arquivo)
   void redimensionaTabelas();
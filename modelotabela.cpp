@@ -0,0 +1,209 @@
+#include "modelotabela.h"
+#include <algorithm>
+#include <climits>
+#include <QString>
+
+//Autores:  Luisa de Moura Galvão Mathias
+//          Marcos Paulo Barbosa
+
+// Thread que executa a geracao da tabela em segundo plano (ModeloTabela::gerar)
+class ThreadTabela : public QThread
+{
+public:
+  explicit ThreadTabela(ModeloTabela *M) : QThread(M), M(M) {}
+
+protected:
+  void run() override { M->gerarSegundoPlano(); }
+
+private:
+  ModeloTabela *M;
+};
+
+ModeloTabela::ModeloTabela(const Circuito *C, QObject *parent) :
+  QAbstractTableModel(parent),
+  C(C), numInputs(0), numOutputs(0), numLinhas(0), gerada(false),
+  thread(new ThreadTabela(this)), cancelar(false), saidas(), bytes_linha(0),
+  linhas_geradas(0), linhas_prontas(0), linhas_publicadas(0),
+  trechos(), proximo_trecho(0), Ctx()
+{
+  // As linhas prontas sao avisadas pela thread de geracao e publicadas nesta thread
+  connect(this, &ModeloTabela::signLinhasProntas,
+          this, &ModeloTabela::slotLinhasProntas, Qt::QueuedConnection);
+  connect(thread, &QThread::finished,
+          this, &ModeloTabela::slotThreadTerminou);
+
+  limpar();
+}
+
+ModeloTabela::~ModeloTabela()
+{
+  parar();
+}
+
+int ModeloTabela::rowCount(const QModelIndex &parent) const
+{
+  return (parent.isValid() ? 0 : numLinhas);
+}
+
+int ModeloTabela::columnCount(const QModelIndex &parent) const
+{
+  return (parent.isValid() ? 0 : numInputs+numOutputs);
+}
+
+QVariant ModeloTabela::data(const QModelIndex &index, int role) const
+{
+  if (!index.isValid()) return QVariant();
+  if (role==Qt::TextAlignmentRole) return int(Qt::AlignCenter);
+  if (role!=Qt::DisplayRole || !gerada) return QVariant();
+
+  int L = index.row();
+  int j = index.column();
+  if (j<numInputs) return QString(toChar(entradaLinha(L, numInputs, j)));
+
+  // Saidas: da geracao em segundo plano, se a linha jah estiver pronta, ou simuladas agora
+  j -= numInputs;
+  if (uint64_t(L) < linhas_prontas.load(std::memory_order_acquire))
+  {
+    uint8_t byte = saidas[uint64_t(L)*bytes_linha + j/4];
+    return QString(toChar(bool3S((byte >> (2*(j%4))) & 3)));
+  }
+  const TrechoTabela &T = trecho(L);
+  return QString(toChar(T.saida(L-int(T.inicio), j)));
+}
+
+QVariant ModeloTabela::headerData(int section, Qt::Orientation orientation, int role) const
+{
+  if (orientation!=Qt::Horizontal) return QVariant();
+  if (role==Qt::TextAlignmentRole) return int(Qt::AlignCenter);
+  if (role!=Qt::DisplayRole) return QVariant();
+
+  if (section<numInputs) return QString("ENTR\n%1").arg(section+1);
+  return QString("SAIDA\n%1").arg(section-numInputs+1);
+}
+
+// Para a geracao, ajusta as dimensoes ao circuito atual e descarta as linhas e os
+// trechos guardados
+void ModeloTabela::limpar()
+{
+  parar();
+
+  beginResetModel();
+  numInputs = C->getNumInputs();
+  numOutputs = C->getNumOutputs();
+  numLinhas = int(std::min<uint64_t>(numLinhasTabela(numInputs), INT_MAX));
+  gerada = false;
+  saidas.clear();
+  saidas.shrink_to_fit();
+  bytes_linha = 0;
+  linhas_geradas = 0;
+  linhas_prontas = 0;
+  linhas_publicadas = 0;
+  trechos.clear();
+  trechos.reserve(TRECHOS_MODELO);
+  proximo_trecho = 0;
+  Ctx.clear();
+  endResetModel();
+}
+
+void ModeloTabela::gerar()
+{
+  if (gerada || !C->prepararContexto(Ctx)) return;
+  gerada = true;
+  // Soh as celulas mudam de valor
+  if (numLinhas>0) emit dataChanged(index(0,0), index(numLinhas-1, numInputs+numOutputs-1));
+
+  // Reserva a memoria das saidas e comeca a gerar
+  bytes_linha = (numOutputs+3)/4;
+  linhas_geradas = std::min<uint64_t>(numLinhas, MAX_BYTES_TABELA/bytes_linha);
+  saidas.assign(linhas_geradas*bytes_linha, 0);
+  linhas_prontas = 0;
+  linhas_publicadas = 0;
+  cancelar = false;
+  thread->start();
+}
+
+void ModeloTabela::parar()
+{
+  if (!thread->isRunning()) return;
+  cancelar = true;
+  thread->wait();
+}
+
+bool ModeloTabela::gerando() const
+{
+  return thread->isRunning();
+}
+
+// Executada na thread de geracao: as linhas sao simuladas em paralelo e recebidas em
+// ordem, trecho a trecho, e as saidas de cada trecho sao guardadas antes de aumentar
+// linhas_prontas. O aviso (signLinhasProntas) soh eh dado a cada 1% das linhas, para
+// nao sobrecarregar a interface
+void ModeloTabela::gerarSegundoPlano()
+{
+  const uint64_t passo = std::max<uint64_t>(linhas_geradas/100, 1);
+  uint64_t avisadas = 0;
+
+  gerarTabelaParalela(*C, 0, linhas_geradas, [&](const TrechoTabela &T)
+  {
+    uint8_t *linha = &saidas[T.inicio*bytes_linha];
+    for (int k=0; k<T.num_linhas; k++, linha+=bytes_linha)
+    {
+      for (int j=0; j<numOutputs; j++) linha[j/4] |= uint8_t(T.saida(k,j)) << (2*(j%4));
+    }
+    uint64_t prontas = T.inicio+T.num_linhas;
+    linhas_prontas.store(prontas, std::memory_order_release);
+    if (prontas-avisadas >= passo)
+    {
+      avisadas = prontas;
+      emit signLinhasProntas();
+    }
+  }, 0, &cancelar);
+}
+
+void ModeloTabela::slotLinhasProntas()
+{
+  uint64_t prontas = linhas_prontas.load(std::memory_order_acquire);
+  if (prontas>linhas_publicadas)
+  {
+    // Soh as colunas das saidas mudam (os valores sao os mesmos calculados sob demanda)
+    emit dataChanged(index(int(linhas_publicadas), numInputs),
+                     index(int(prontas-1), numInputs+numOutputs-1));
+    linhas_publicadas = prontas;
+  }
+  if (linhas_geradas>0) emit signProgresso(int(100*prontas/linhas_geradas));
+}
+
+void ModeloTabela::slotThreadTerminou()
+{
+  // Aviso atrasado de uma geracao anterior (a thread jah foi reiniciada)
+  if (thread->isRunning()) return;
+  slotLinhasProntas();
+  emit signFimGeracao(gerada && linhas_prontas.load()==linhas_geradas);
+}
+
+// Procura o trecho entre os guardados; se nao estiver, simula o trecho no lugar do
+// guardado ha mais tempo
+const TrechoTabela &ModeloTabela::trecho(int L) const
+{
+  for (unsigned t=0; t<trechos.size(); t++)
+  {
+    if (uint64_t(L)>=trechos[t].inicio && uint64_t(L)<trechos[t].inicio+trechos[t].num_linhas)
+    {
+      return trechos[t];
+    }
+  }
+
+  if (int(trechos.size())<TRECHOS_MODELO)
+  {
+    trechos.push_back(TrechoTabela());
+    proximo_trecho = trechos.size()-1;
+  }
+  else proximo_trecho = (proximo_trecho+1)%TRECHOS_MODELO;
+  TrechoTabela &T = trechos[proximo_trecho];
+
+  uint64_t inicio = uint64_t(L) - uint64_t(L)%LINHAS_TRECHO;
+  uint64_t total = numLinhasTabela(numInputs);
+  montarTrecho(T, numInputs, inicio, int(std::min<uint64_t>(LINHAS_TRECHO, total-inicio)));
+  C->simularLote(T.in_circ, T.num_palavras, T.out_circ, Ctx);
+  return T;
+}
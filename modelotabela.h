@@ -0,0 +1,141 @@
+#ifndef MODELOTABELA_H
+#define MODELOTABELA_H
+
+//Autores:  Luisa de Moura Galvão Mathias
+//          Marcos Paulo Barbosa
+
+#include <QAbstractTableModel>
+#include <QThread>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "circuito.h"
+#include "contexto.h"
+#include "tabela.h"
+
+/* ======================================================================== *
+ * ESSA EH A CLASSE QUE FORNECE A TABELA VERDADE PARA A TELA PRINCIPAL      *
+ * ======================================================================== */
+
+// Modelo (QAbstractTableModel) da tabela verdade exibida em um QTableView
+// A coluna j eh a entrada de id -(j+1) (j < numInputs) ou a saida de id j-numInputs+1
+// Os valores das entradas sao calculados a partir do indice da linha (entradaLinha)
+//
+// A tabela eh gerada em segundo plano (gerar), por uma thread que chama
+// gerarTabelaParalela e guarda as saidas de cada linha com 2 bits por valor. As linhas
+// prontas sao publicadas aos poucos (dataChanged), e o andamento eh informado por
+// signProgresso, de modo que a interface nunca fica bloqueada. A geracao pode ser
+// cancelada (parar)
+// As linhas que ainda nao ficaram prontas (ou que passam do limite de memoria
+// MAX_BYTES_TABELA) sao simuladas quando a view pede o valor de uma celula: o modelo
+// simula (Circuito::simularLote) o trecho de LINHAS_TRECHO linhas que contem a celula e
+// guarda apenas os ultimos TRECHOS_MODELO trechos simulados
+//
+// ATENCAO: enquanto a geracao estiver em andamento, o circuito nao pode ser alterado
+// (chamar parar antes de qualquer alteracao)
+
+// Numero de trechos simulados guardados pelo modelo
+const int TRECHOS_MODELO = 16;
+
+// Memoria maxima usada para guardar as saidas geradas em segundo plano
+const uint64_t MAX_BYTES_TABELA = 64<<20;
+
+class ModeloTabela : public QAbstractTableModel
+{
+  Q_OBJECT
+
+  friend class ThreadTabela;
+
+public:
+  // O modelo exibe a tabela verdade do circuito C, que continua pertencendo a quem chamou
+  explicit ModeloTabela(const Circuito *C, QObject *parent = 0);
+  // Destrutor: para a geracao, se estiver em andamento
+  ~ModeloTabela();
+
+  // Funcoes de QAbstractTableModel
+  // O numero de linhas eh 3^numInputs (limitado ao maior int)
+  int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+  // O valor (? F T) da celula. Enquanto a tabela nao for gerada, as celulas ficam vazias
+  QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+  // Os cabecalhos das colunas: ENTR 1, ..., SAIDA 1, ...
+  QVariant headerData(int section, Qt::Orientation orientation,
+                      int role = Qt::DisplayRole) const override;
+
+  // Para a geracao (se houver), ajusta as dimensoes da tabela ao circuito e descarta
+  // os valores
+  // Deve ser chamada sempre que o circuito mudar (criar novo, ler de arquivo ou alterar)
+  void limpar();
+
+  // Passa a exibir os valores da tabela verdade e comeca a gera-la em segundo plano
+  // O circuito deve ser valido
+  void gerar();
+
+  // Cancela a geracao em segundo plano e espera a thread terminar
+  // As linhas jah prontas continuam guardadas; as demais passam a ser simuladas
+  // quando forem exibidas
+  void parar();
+
+  // Retorna true se a geracao em segundo plano estah em andamento
+  bool gerando() const;
+
+signals:
+  // Andamento da geracao em segundo plano (de 0 a 100)
+  void signProgresso(int percentual);
+  // Fim da geracao em segundo plano: completa eh false se foi cancelada
+  void signFimGeracao(bool completa);
+
+  // Emitido pela thread de geracao quando ha novas linhas prontas
+  void signLinhasProntas();
+
+private slots:
+  // Publica as linhas que ficaram prontas desde a ultima chamada (dataChanged)
+  void slotLinhasProntas();
+  // Chamada quando a thread de geracao termina
+  void slotThreadTerminou();
+
+private:
+  // O circuito cuja tabela eh exibida
+  const Circuito *C;
+
+  // As dimensoes da tabela
+  int numInputs, numOutputs, numLinhas;
+
+  // true depois de gerar (ateh o proximo limpar)
+  bool gerada;
+
+  /// Geracao em segundo plano
+
+  // A thread que gera a tabela
+  QThread *thread;
+  // Pedido de cancelamento, lido por gerarTabelaParalela
+  std::atomic<bool> cancelar;
+  // As saidas das linhas 0 a linhas_prontas-1, com bytes_linha bytes por linha
+  // (a saida j+1 nos bits 2*(j%4) e 2*(j%4)+1 do byte j/4 da linha, como no formato
+  // binario de exportarTabela)
+  // A thread soh escreve nas linhas a partir de linhas_prontas, e a interface soh leh as
+  // linhas anteriores
+  std::vector<uint8_t> saidas;
+  int bytes_linha;
+  // Numero de linhas que a thread vai gerar (limitado por MAX_BYTES_TABELA)
+  uint64_t linhas_geradas;
+  std::atomic<uint64_t> linhas_prontas;
+  // Numero de linhas jah publicadas (dataChanged)
+  uint64_t linhas_publicadas;
+
+  // Funcao executada pela thread de geracao
+  void gerarSegundoPlano();
+
+  /// Simulacao sob demanda
+
+  // Os trechos simulados mais recentemente, substituidos em rodizio, e o contexto usado
+  // para simula-los (sao "mutable" porque sao preenchidos pela funcao const data)
+  mutable std::vector<TrechoTabela> trechos;
+  mutable int proximo_trecho;
+  mutable ContextoSimulacao Ctx;
+
+  // Retorna o trecho que contem a linha L, simulando-o se ainda nao estiver guardado
+  const TrechoTabela &trecho(int L) const;
+};
+
+#endif // MODELOTABELA_H
@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <string>
+#include "netlist.h"
+
+//Autores:  Luisa de Moura Galvão Mathias
+//          Marcos Paulo Barbosa
+
+///
+/// NETLIST PLANA
+///
+
+NetlistPlana::NetlistPlana(): Nin(0), tipo(), sinal(), inicio_in(), sinal_in(), sinal_out() {}
+
+void NetlistPlana::clear()
+{
+  Nin = 0;
+  tipo.clear();
+  sinal.clear();
+  inicio_in.clear();
+  sinal_in.clear();
+  sinal_out.clear();
+}
+
+///
+/// FORMATO BINARIO DA NETLIST
+///
+
+static const char ASSINATURA_NETLIST[8] = {'C','I','R','C','3','S','B','\0'};
+
+// Numero de bytes de uma parte com N elementos de Tam bytes, arredondado para multiplo de 4
+static size_t tamanhoParte(size_t N, size_t Tam)
+{
+  return (N*Tam+3)/4*4;
+}
+
+// Grava os N elementos a partir de V, seguidos dos bytes de enchimento
+static void escreverParte(std::ostream& O, const void* V, size_t N, size_t Tam)
+{
+  static const char zeros[4] = {0, 0, 0, 0};
+  if (N>0) O.write(static_cast<const char*>(V), N*Tam);
+  O.write(zeros, tamanhoParte(N, Tam)-N*Tam);
+}
+
+bool escreverNetlistBinaria(std::ostream& O, const NetlistPlana& P,
+                            const std::vector<int>& Bloco, const std::vector<bool>& Ciclo)
+{
+  CabecalhoNetlist C;
+  std::copy(ASSINATURA_NETLIST, ASSINATURA_NETLIST+8, C.assinatura);
+  C.versao = VERSAO_NETLIST;
+  C.marca_bytes = MARCA_BYTES_NETLIST;
+  C.Nin = P.Nin;
+  C.Nout = P.sinal_out.size();
+  C.Nports = P.getNumPorts();
+  C.Nligacoes = P.sinal_in.size();
+  C.Nblocos = Ciclo.size();
+  C.reservado = 0;
+
+  std::vector<uint8_t> ciclo(Ciclo.begin(), Ciclo.end());
+  O.write(reinterpret_cast<const char*>(&C), sizeof(C));
+  escreverParte(O, P.tipo.data(), C.Nports, sizeof(TipoPorta));
+  escreverParte(O, P.sinal.data(), C.Nports, sizeof(int32_t));
+  escreverParte(O, P.inicio_in.data(), C.Nports+1, sizeof(int32_t));
+  escreverParte(O, P.sinal_in.data(), C.Nligacoes, sizeof(int32_t));
+  escreverParte(O, P.sinal_out.data(), C.Nout, sizeof(int32_t));
+  escreverParte(O, Bloco.data(), C.Nblocos+1, sizeof(int32_t));
+  escreverParte(O, ciclo.data(), C.Nblocos, sizeof(uint8_t));
+  return bool(O);
+}
+
+void lerNetlistBinaria(const char* Dados, size_t Tam, NetlistPlana& P,
+                       std::vector<int>& Bloco, std::vector<bool>& Ciclo)
+{
+  CabecalhoNetlist C;
+  if (Tam<sizeof(C)) throw ErroLeitura(0, 0, "arquivo binario muito pequeno");
+  std::copy(Dados, Dados+sizeof(C), reinterpret_cast<char*>(&C));
+  if (!std::equal(ASSINATURA_NETLIST, ASSINATURA_NETLIST+8, C.assinatura))
+    throw ErroLeitura(0, 0, "nao eh um arquivo binario de circuito");
+  if (C.marca_bytes!=MARCA_BYTES_NETLIST)
+    throw ErroLeitura(0, 0, "arquivo binario gravado com outra ordem de bytes");
+  if (C.versao!=VERSAO_NETLIST)
+    throw ErroLeitura(0, 0, "versao do arquivo binario nao suportada: " + std::to_string(C.versao));
+
+  // Os tamanhos sao limitados para que as contas abaixo nao estourem
+  const uint32_t LIMITE = uint32_t(INT32_MAX)/4;
+  if (C.Nin==0 || C.Nout==0 || C.Nports==0 || C.Nblocos==0 || C.Nblocos>C.Nports ||
+      C.Nin>LIMITE || C.Nout>LIMITE || C.Nports>LIMITE || C.Nligacoes>LIMITE ||
+      uint64_t(C.Nin)+C.Nports>LIMITE)
+    throw ErroLeitura(0, 0, "cabecalho do arquivo binario invalido");
+
+  const size_t NP = C.Nports, NS = size_t(C.Nin)+C.Nports;
+  size_t pos = sizeof(C);
+  size_t tamanho = pos + tamanhoParte(NP, 1) + tamanhoParte(NP, 4) + tamanhoParte(NP+1, 4) +
+                   tamanhoParte(C.Nligacoes, 4) + tamanhoParte(C.Nout, 4) +
+                   tamanhoParte(C.Nblocos+1, 4) + tamanhoParte(C.Nblocos, 1);
+  if (Tam!=tamanho) throw ErroLeitura(0, 0, "tamanho do arquivo binario nao confere com o cabecalho");
+
+  auto parte = [&](size_t N, size_t T)
+  {
+    const char* inicio = Dados+pos;
+    pos += tamanhoParte(N, T);
+    return inicio;
+  };
+  const TipoPorta* tipo = reinterpret_cast<const TipoPorta*>(parte(NP, 1));
+  const int32_t* sinal = reinterpret_cast<const int32_t*>(parte(NP, 4));
+  const int32_t* inicio_in = reinterpret_cast<const int32_t*>(parte(NP+1, 4));
+  const int32_t* sinal_in = reinterpret_cast<const int32_t*>(parte(C.Nligacoes, 4));
+  const int32_t* sinal_out = reinterpret_cast<const int32_t*>(parte(C.Nout, 4));
+  const int32_t* bloco = reinterpret_cast<const int32_t*>(parte(C.Nblocos+1, 4));
+  const uint8_t* ciclo = reinterpret_cast<const uint8_t*>(parte(C.Nblocos, 1));
+
+  // Cada porta aparece uma vez, com um numero de entradas valido para o tipo (como
+  // inicio_in eh crescente e termina em Nligacoes, todas as posicoes de sinal_in sao validas)
+  // posicao[s]: posicao em que o sinal s eh calculado (-1 para as entradas do circuito)
+  std::vector<int> posicao(NS, -2);
+  for (int i=0; i<int(C.Nin); i++) posicao[i] = -1;
+  if (inicio_in[0]!=0 || inicio_in[NP]!=int32_t(C.Nligacoes))
+    throw ErroLeitura(0, 0, "ligacoes das portas invalidas no arquivo binario");
+  for (size_t k=0; k<NP; k++)
+  {
+    int64_t NI = int64_t(inicio_in[k+1])-inicio_in[k];
+    if (uint8_t(tipo[k])>uint8_t(TipoPorta::NX) || NI<1 ||
+        (tipo[k]==TipoPorta::NT ? NI!=1 : NI<2))
+      throw ErroLeitura(0, 0, "porta invalida na posicao " + std::to_string(k) + " do arquivo binario");
+    if (sinal[k]<int32_t(C.Nin) || size_t(sinal[k])>=NS || posicao[sinal[k]]!=-2)
+      throw ErroLeitura(0, 0, "sinal invalido na posicao " + std::to_string(k) + " do arquivo binario");
+    posicao[sinal[k]] = k;
+  }
+  for (size_t j=0; j<C.Nout; j++)
+  {
+    if (sinal_out[j]<0 || size_t(sinal_out[j])>=NS)
+      throw ErroLeitura(0, 0, "saida invalida no arquivo binario: " + std::to_string(j+1));
+  }
+
+  // Os blocos cobrem todas as portas, e cada porta soh le sinais de posicoes anteriores
+  // ou do seu proprio bloco com realimentacao
+  if (bloco[0]!=0 || bloco[C.Nblocos]!=int32_t(NP))
+    throw ErroLeitura(0, 0, "blocos de simulacao invalidos no arquivo binario");
+  for (size_t b=0; b<C.Nblocos; b++)
+  {
+    if (bloco[b+1]<=bloco[b] || ciclo[b]>1 || (!ciclo[b] && bloco[b+1]-bloco[b]!=1))
+      throw ErroLeitura(0, 0, "blocos de simulacao invalidos no arquivo binario");
+    for (int k=bloco[b]; k<bloco[b+1]; k++)
+    {
+      for (int m=inicio_in[k]; m<inicio_in[k+1]; m++)
+      {
+        int32_t s = sinal_in[m];
+        if (s<0 || size_t(s)>=NS || posicao[s]>=(ciclo[b] ? bloco[b+1] : k))
+          throw ErroLeitura(0, 0, "ligacao invalida na posicao " + std::to_string(k) + " do arquivo binario");
+      }
+    }
+  }
+
+  P.Nin = C.Nin;
+  P.tipo.apontar(tipo, NP);
+  P.sinal.apontar(sinal, NP);
+  P.inicio_in.apontar(inicio_in, NP+1);
+  P.sinal_in.apontar(sinal_in, C.Nligacoes);
+  P.sinal_out.apontar(sinal_out, C.Nout);
+  Bloco.assign(bloco, bloco+C.Nblocos+1);
+  Ciclo.assign(ciclo, ciclo+C.Nblocos);
+}
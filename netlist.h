@@ -0,0 +1,248 @@
+#ifndef _NETLIST_H_
+#define _NETLIST_H_
+
+//Autores:  Luisa de Moura Galvão Mathias
+//          Marcos Paulo Barbosa
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+#include "arquivo.h"
+#include "bool3S.h"
+#include "bool3S_64.h"
+#include "port.h"
+
+///
+/// VETOR DA NETLIST PLANA
+///
+
+// Vetor somente de leitura usado pela NetlistPlana: os elementos pertencem ao proprio
+// vetor (assumir) ou estao em uma memoria externa (apontar), por exemplo um arquivo
+// binario mapeado em memoria, que deve continuar existindo enquanto o vetor for usado
+template<class T>
+class VetorPlano {
+private:
+  // Os elementos, quando pertencem ao vetor
+  std::vector<T> dono;
+  // O inicio e o numero de elementos (em dono ou na memoria externa)
+  const T* inicio;
+  size_t tam;
+
+public:
+  VetorPlano(): dono(), inicio(nullptr), tam(0) {}
+  // A copia de um vetor com memoria externa aponta para a mesma memoria
+  VetorPlano(const VetorPlano& V): dono(V.dono), inicio(V.dono.empty() ? V.inicio : dono.data()), tam(V.tam) {}
+  void operator=(const VetorPlano& V)
+  {
+    if (this == &V) return;
+    dono = V.dono;
+    inicio = (dono.empty() ? V.inicio : dono.data());
+    tam = V.tam;
+  }
+
+  // Passa a usar os elementos de V (sem copiar)
+  void assumir(std::vector<T>&& V)
+  {
+    dono = std::move(V);
+    inicio = dono.data();
+    tam = dono.size();
+  }
+  // Passa a usar os N elementos da memoria externa que comeca em Inicio
+  void apontar(const T* Inicio, size_t N)
+  {
+    dono.clear();
+    dono.shrink_to_fit();
+    inicio = Inicio;
+    tam = N;
+  }
+  // Esvazia o vetor, liberando a memoria
+  void clear() { apontar(nullptr, 0); }
+
+  const T& operator[](size_t i) const { return inicio[i]; }
+  size_t size() const { return tam; }
+  const T* data() const { return inicio; }
+};
+
+///
+/// NETLIST PLANA
+///
+
+// Representacao compacta das portas de um Circuito, usada pelos metodos de simulacao
+// no lugar dos objetos Port (um objeto alocado para cada porta, com o seu proprio
+// vetor de entradas). Cada informacao fica em um vetor continuo, e as portas estao na
+// ordem de simulacao: a porta que estah na posicao k eh simulada antes da que estah
+// na posicao k+1 (a menos dos blocos com realimentacao), de modo que a simulacao
+// percorre os vetores sequencialmente
+// Os sinais sao identificados pelo seu indice: as entradas do circuito sao os sinais
+// 0 a Nin-1 (id -1 a -Nin) e as portas sao os sinais Nin a Nin+Nports-1 (id 1 a Nports)
+// Ocupa cerca de 10 bytes por porta mais 4 bytes por entrada de porta
+// Os vetores sao montados pelo Circuito (VetorPlano::assumir) ou apontam diretamente
+// para um arquivo no formato binario (lerNetlistBinaria)
+
+struct NetlistPlana {
+  // Numero de entradas do circuito (indice do sinal da primeira porta)
+  int Nin;
+  // O tipo da porta na posicao k
+  VetorPlano<TipoPorta> tipo;
+  // O indice do sinal de saida da porta na posicao k (Nin+IdPort-1)
+  VetorPlano<int32_t> sinal;
+  // Os indices dos sinais de entrada da porta na posicao k sao
+  // sinal_in[inicio_in[k]] a sinal_in[inicio_in[k+1]-1]
+  // inicio_in tem um elemento a mais que tipo
+  VetorPlano<int32_t> inicio_in;
+  VetorPlano<int32_t> sinal_in;
+  // O indice do sinal de cada saida do circuito
+  VetorPlano<int32_t> sinal_out;
+
+  // Cria uma netlist vazia
+  NetlistPlana();
+
+  // Esvazia todos os vetores
+  void clear();
+
+  // Numero de portas e numero total de sinais (entradas do circuito e portas)
+  int getNumPorts() const { return tipo.size(); }
+  int getNumSinais() const { return Nin+getNumPorts(); }
+
+  // Calcula a saida da porta na posicao k a partir dos valores de todos os sinais
+  // (val[s] eh o valor do sinal de indice s). V eh bool3S ou bool3S_64
+  template<class V> V calcular(int k, const V* val) const;
+
+  // Simula as portas nas posicoes inicio a fim-1, todas do tipo tipo[inicio] e fora de
+  // blocos com realimentacao, guardando as saidas em val
+  // O tipo eh testado uma unica vez: cada tipo de porta tem o seu proprio laco
+  template<class V> void simularSequencia(int inicio, int fim, V* val) const;
+
+private:
+  // Os lacos especializados para cada tipo de porta
+  template<TipoPorta T, class V> void simularSequenciaTipo(int inicio, int fim, V* val) const;
+};
+
+///
+/// FORMATO BINARIO DA NETLIST
+///
+
+// Um arquivo binario guarda a NetlistPlana de um circuito e os seus blocos de simulacao
+// exatamente como ficam na memoria, de modo que pode ser mapeado (ArquivoMapeado) e
+// simulado sem nenhuma conversao. Todos os numeros estao na ordem de bytes da maquina
+// que gravou o arquivo (conferida na leitura), e o arquivo eh formado por:
+// - o cabecalho (CabecalhoNetlist)
+// - tipo: Nports bytes (TipoPorta)
+// - sinal: Nports int32
+// - inicio_in: Nports+1 int32
+// - sinal_in: Nligacoes int32
+// - sinal_out: Nout int32
+// - bloco: Nblocos+1 int32 (posicao do inicio de cada bloco de simulacao)
+// - ciclo: Nblocos bytes (1 se o bloco tem realimentacao)
+// Cada parte comeca em uma posicao multipla de 4 (com bytes 0 de enchimento)
+
+// A versao atual do formato (muda sempre que o formato mudar)
+const uint32_t VERSAO_NETLIST = 1;
+
+struct CabecalhoNetlist {
+  // "CIRC3SB" seguido de um byte 0
+  char assinatura[8];
+  // VERSAO_NETLIST
+  uint32_t versao;
+  // MARCA_BYTES_NETLIST, para conferir a ordem dos bytes
+  uint32_t marca_bytes;
+  uint32_t Nin, Nout, Nports, Nligacoes, Nblocos;
+  // Sempre 0
+  uint32_t reservado;
+};
+
+const uint32_t MARCA_BYTES_NETLIST = 0x01020304;
+
+// Grava em O a netlist P (no formato binario) e os seus blocos de simulacao: o bloco b
+// vai da posicao Bloco[b] a Bloco[b+1]-1 e Ciclo[b] indica se tem realimentacao
+// Retorna true se deu tudo OK; false se deu erro na gravacao
+bool escreverNetlistBinaria(std::ostream& O, const NetlistPlana& P,
+                            const std::vector<int>& Bloco, const std::vector<bool>& Ciclo);
+
+// Faz os vetores de P apontarem para a netlist contida nos Tam bytes a partir de Dados
+// (que devem continuar existindo enquanto P for usada) e copia os blocos de simulacao
+// para Bloco e Ciclo. Dados deve estar alinhado em 4 bytes
+// Confere o cabecalho e todos os indices, de modo que a simulacao nunca acessa
+// posicoes invalidas, e que as portas estao em ordem topologica (cada porta fora de
+// um bloco com realimentacao soh depende de sinais anteriores)
+// Lanca ErroLeitura (sem linha e coluna) se o conteudo for invalido
+void lerNetlistBinaria(const char* Dados, size_t Tam, NetlistPlana& P,
+                       std::vector<int>& Bloco, std::vector<bool>& Ciclo);
+
+/// ***********************
+/// Calculo das portas por tipo
+/// ***********************
+
+// Calcula a saida de uma porta do tipo T cujas entradas sao os sinais de indices
+// *s a *(fim-1). O tipo eh conhecido na compilacao, de modo que nao ha chamada virtual
+// nem teste do tipo dentro do laco. V eh bool3S ou bool3S_64 (mesmos operadores)
+// Com bool3S, o AND (OR) para no primeiro FALSE (TRUE), que define o resultado, como
+// and3S e or3S; com bool3S_64 cada bit teria que parar em um ponto diferente
+template<TipoPorta T, class V>
+inline V calcularPorta(const int* s, const int* fim, const V* val)
+{
+  constexpr bool escalar = std::is_same<V, bool3S>::value;
+  V out = val[*s];
+  for (++s; s!=fim; ++s)
+  {
+    if constexpr (T==TipoPorta::AN || T==TipoPorta::NA)
+    {
+      if constexpr (escalar) if (out==bool3S::FALSE) break;
+      out = out & val[*s];
+    }
+    else if constexpr (T==TipoPorta::OR || T==TipoPorta::NO)
+    {
+      if constexpr (escalar) if (out==bool3S::TRUE) break;
+      out = out | val[*s];
+    }
+    else out = out ^ val[*s];
+  }
+  if constexpr (T==TipoPorta::NT || T==TipoPorta::NA || T==TipoPorta::NO || T==TipoPorta::NX) return ~out;
+  else return out;
+}
+
+template<class V>
+V NetlistPlana::calcular(int k, const V* val) const
+{
+  const int* s = &sinal_in[inicio_in[k]];
+  const int* fim = &sinal_in[inicio_in[k+1]];
+
+  switch (tipo[k])
+  {
+  case TipoPorta::NT: return calcularPorta<TipoPorta::NT>(s, fim, val);
+  case TipoPorta::AN: return calcularPorta<TipoPorta::AN>(s, fim, val);
+  case TipoPorta::NA: return calcularPorta<TipoPorta::NA>(s, fim, val);
+  case TipoPorta::OR: return calcularPorta<TipoPorta::OR>(s, fim, val);
+  case TipoPorta::NO: return calcularPorta<TipoPorta::NO>(s, fim, val);
+  case TipoPorta::XO: return calcularPorta<TipoPorta::XO>(s, fim, val);
+  default:            return calcularPorta<TipoPorta::NX>(s, fim, val);
+  }
+}
+
+template<TipoPorta T, class V>
+void NetlistPlana::simularSequenciaTipo(int inicio, int fim, V* val) const
+{
+  for (int k=inicio; k<fim; k++)
+  {
+    val[sinal[k]] = calcularPorta<T>(&sinal_in[inicio_in[k]], &sinal_in[inicio_in[k+1]], val);
+  }
+}
+
+template<class V>
+void NetlistPlana::simularSequencia(int inicio, int fim, V* val) const
+{
+  switch (tipo[inicio])
+  {
+  case TipoPorta::NT: simularSequenciaTipo<TipoPorta::NT>(inicio, fim, val); break;
+  case TipoPorta::AN: simularSequenciaTipo<TipoPorta::AN>(inicio, fim, val); break;
+  case TipoPorta::NA: simularSequenciaTipo<TipoPorta::NA>(inicio, fim, val); break;
+  case TipoPorta::OR: simularSequenciaTipo<TipoPorta::OR>(inicio, fim, val); break;
+  case TipoPorta::NO: simularSequenciaTipo<TipoPorta::NO>(inicio, fim, val); break;
+  case TipoPorta::XO: simularSequenciaTipo<TipoPorta::XO>(inicio, fim, val); break;
+  default:            simularSequenciaTipo<TipoPorta::NX>(inicio, fim, val); break;
+  }
+}
+
+#endif // _NETLIST_H_
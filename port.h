@@ -4,8 +4,11 @@
 //Autores:  Luisa de Moura Galvo Mathias
 //          Marcos Paulo Barbosa
 
+#include <cstdint>
 #include <iostream>
+#include <memory_resource>
 #include <string>
+#include <utility> // para std::forward
 #include <vector>
 #include "bool3S.h"
 
@@ -14,6 +17,14 @@
 /// int I: indice (de entrada de porta): de 0 a NInputs-1
 /// ###########################################################################
 
+//
+// OS TIPOS DE PORTA
+//
+
+// Os tipos de porta, na mesma ordem das siglas (NT, AN, NA, OR, NO, XO, NX)
+// Usado na representacao compacta das portas para simulacao (NetlistPlana)
+enum class TipoPorta : uint8_t { NT, AN, NA, OR, NO, XO, NX };
+
 //
 // A CLASSE PORT
 //
@@ -34,7 +45,9 @@ protected:
   // se id_in[i]<0: a i-esima entrada da porta vem da entrada do circuito cuja id eh o
   // valor desse elemento do array
   // se id_in[i]==0: a i-esima entrada da porta estah indefinida
-  std::vector<int> id_in;
+  // O vetor usa o mesmo recurso de memoria da porta (ver criarPorta), de modo que as
+  // portas de um circuito e as suas entradas ficam todas na arena do circuito
+  std::pmr::vector<int> id_in;
   // O valor logico (bool3S) da saida da porta (?, F ou T)
   bool3S out_port;
 
@@ -46,7 +59,10 @@ public:
   // Construtor (recebe como parametro o numero de entradas da porta)
   // Testa o parametro (validNumInputs), dimensiona e inicializa os elementos
   // do array id_in com valor invalido (0), inicializa out_port com UNDEF
-  Port(int NI=2);
+  // Mem eh o recurso de memoria de onde vem o vetor id_in (por padrao, new/delete)
+  Port(int NI=2, std::pmr::memory_resource* Mem=std::pmr::get_default_resource());
+  // Construtor por copia com o vetor id_in alocado em Mem
+  Port(const Port& P, std::pmr::memory_resource* Mem);
   // Destrutor virtual
   virtual ~Port();
 
@@ -56,6 +72,10 @@ public:
   // uma area que contem uma Port_AND cujo valor eh uma copia de *this
   // Deve ser utilizada, por exemplo, no construtor por copia da classe Circuito
   virtual ptr_Port clone() const = 0;
+  // Igual ao anterior, mas criando a copia com criarPorta no recurso de memoria Mem
+  // (a porta deve ser destruida com destruirPorta). Deve ser utilizada para copiar as
+  // portas para a arena de um Circuito
+  virtual ptr_Port clone(std::pmr::memory_resource* Mem) const = 0;
 
   /// ***********************
   /// Funcoes de testagem
@@ -86,6 +106,11 @@ public:
   // Deve ser utilizada para imprimir uma porta
   virtual std::string getName() const = 0;
 
+  // Funcao virtual pura que retorna o tipo da Port (TipoPorta::AN, TipoPorta::NT, etc.)
+  // Deve ser utilizada para identificar o tipo sem comparar strings (por exemplo, ao
+  // montar a representacao compacta do circuito para simulacao)
+  virtual TipoPorta getTipo() const = 0;
+
   // Caracteristicas da porta
   int getNumInputs() const;
 
@@ -164,15 +189,38 @@ public:
 
   // Simula uma porta logica
   // Recebe um vector de bool3S com os valores logicos atuais das entradas da porta
-  // A implementacao desse metodo virtual nas classes derivadas (Port_AND, etc) deve:
-  // 1) Testar se a dimensao do vetor eh igual ao numero de entradas da porta,
+  // 1) Testa se a dimensao do vetor eh igual ao numero de entradas da porta,
   //    utilizando testValidSizeInputs
-  // 2) Simular a porta, baseando-se nos operadores AND, OR, etc da classe bool3S.
-  // 3) Armazenar o valor bool3S com o resultado da simulacao (saida da porta)
-  //    no dado "out_port" da porta
-  virtual void simular(const std::vector<bool3S>& in_port)= 0;
+  // 2) Armazena o valor bool3S com o resultado da simulacao (calculado pelo
+  //    metodo virtual calcular) no dado "out_port" da porta
+  void simular(const std::vector<bool3S>& in_port);
+
+  // Calcula a saida de uma porta logica
+  // Recebe um vector de bool3S com os valores logicos atuais das entradas da porta
+  // e retorna o valor bool3S com o resultado da simulacao, baseando-se nos operadores
+  // AND, OR, etc da classe bool3S. Nao altera o dado "out_port" da porta, de modo que
+  // a mesma porta pode ser simulada ao mesmo tempo por varias threads
+  // (a classe Circuito guarda os valores das portas em um ContextoSimulacao)
+  // Se a dimensao do vetor for diferente do numero de entradas da porta, retorna UNDEF
+  virtual bool3S calcular(const std::vector<bool3S>& in_port) const = 0;
 };
 
+// Cria uma porta do tipo P (Port_AND, Port_NOT, etc.) cujo objeto e vetor de entradas
+// sao alocados no recurso de memoria Mem. Os argumentos sao passados ao construtor de P,
+// seguidos por Mem
+// Mem deve ser uma arena (std::pmr::monotonic_buffer_resource, por exemplo): a porta
+// deve ser destruida com destruirPorta, e a memoria soh eh devolvida quando a arena for
+// liberada
+template<class P, class... Args>
+ptr_Port criarPorta(std::pmr::memory_resource* Mem, Args&&... args)
+{
+  void* area = Mem->allocate(sizeof(P), alignof(P));
+  return new (area) P(std::forward<Args>(args)..., Mem);
+}
+
+// Destroi uma porta criada com criarPorta (chama o destrutor sem liberar a memoria)
+void destruirPorta(ptr_Port P);
+
 // Operador << com comportamento polimorfico
 // Serve para todas as ports (NO, AND, NOR, etc.)
 std::ostream& operator<<(std::ostream& O, const Port& X);
@@ -183,11 +231,15 @@ std::ostream& operator<<(std::ostream& O, const Port& X);
 
 class Port_NOT: public Port {
 public:
-  Port_NOT();
+  Port_NOT(std::pmr::memory_resource* Mem=std::pmr::get_default_resource());
+  Port_NOT(const Port_NOT& P, std::pmr::memory_resource* Mem);
   // Retorna new Port_NOT(*this)
   ptr_Port clone() const;
+  ptr_Port clone(std::pmr::memory_resource* Mem) const;
   // Retorna "NT"
   std::string getName() const;
+  // Retorna TipoPorta::NT
+  TipoPorta getTipo() const;
 
   bool validNumInputs(int NI) const;
 
@@ -197,101 +249,118 @@ public:
   // Se o usuario digitar um dado invalido, o metodo deve pedir que ele digite novamente
   void digitar();
 
-  // Testa se a dimensao do vetor in_port eh igual ao numero de entradas da porta (1);
-  // se nao for, faz out_port <- UNDEF e retorna.
-  // Armazena o valor bool3S com o resultado da simulacao (saida da porta)
-  // no dado "out_port" da porta
-  void simular(const std::vector<bool3S>& in_port);
+  // Retorna o valor bool3S com o resultado da simulacao (saida da porta),
+  // sem alterar o dado "out_port" da porta
+  // Se a dimensao do vetor in_port for diferente do numero de entradas da porta, retorna UNDEF
+  bool3S calcular(const std::vector<bool3S>& in_port) const;
 };
 
 class Port_AND: public Port {
 public:
-  Port_AND();
+  Port_AND(std::pmr::memory_resource* Mem=std::pmr::get_default_resource());
+  Port_AND(const Port_AND& P, std::pmr::memory_resource* Mem);
   // Retorna new Port_AND(*this)
   ptr_Port clone() const;
+  ptr_Port clone(std::pmr::memory_resource* Mem) const;
   // Retorna "AN"
   std::string getName() const;
+  // Retorna TipoPorta::AN
+  TipoPorta getTipo() const;
 
-  // Testa se a dimensao do vetor in_port eh igual ao numero de entradas da porta;
-  // se no for, faz out_port <- UNDEF e retorna.
-  // Armazena o valor bool3S com o resultado da simulacao (saida da porta)
-  // no dado "out_port" da porta
-  void simular(const std::vector<bool3S>& in_port);
+  // Retorna o valor bool3S com o resultado da simulacao (saida da porta),
+  // sem alterar o dado "out_port" da porta
+  // Se a dimensao do vetor in_port for diferente do numero de entradas da porta, retorna UNDEF
+  bool3S calcular(const std::vector<bool3S>& in_port) const;
 };
 
 class Port_NAND: public Port {
 public:
-  Port_NAND();
+  Port_NAND(std::pmr::memory_resource* Mem=std::pmr::get_default_resource());
+  Port_NAND(const Port_NAND& P, std::pmr::memory_resource* Mem);
   // Retorna new Port_NAND(*this)
   ptr_Port clone() const;
+  ptr_Port clone(std::pmr::memory_resource* Mem) const;
   // Retorna "NA"
   std::string getName() const;
+  // Retorna TipoPorta::NA
+  TipoPorta getTipo() const;
 
-  // Testa se a dimensao do vetor in_port eh igual ao numero de entradas da porta;
-  // se nao for, faz out_port <- UNDEF e retorna.
-  // Armazena o valor bool3S com o resultado da simulacao (saida da porta)
-  // no dado "out_port" da porta
-  void simular(const std::vector<bool3S>& in_port);
+  // Retorna o valor bool3S com o resultado da simulacao (saida da porta),
+  // sem alterar o dado "out_port" da porta
+  // Se a dimensao do vetor in_port for diferente do numero de entradas da porta, retorna UNDEF
+  bool3S calcular(const std::vector<bool3S>& in_port) const;
 };
 
 class Port_OR: public Port {
 public:
-  Port_OR();
+  Port_OR(std::pmr::memory_resource* Mem=std::pmr::get_default_resource());
+  Port_OR(const Port_OR& P, std::pmr::memory_resource* Mem);
   // Retorna new Port_OR(*this)
   ptr_Port clone() const;
+  ptr_Port clone(std::pmr::memory_resource* Mem) const;
   // Retorna "OR"
   std::string getName() const;
+  // Retorna TipoPorta::OR
+  TipoPorta getTipo() const;
 
-  // Testa se a dimensao do vetor in_port eh igual ao numero de entradas da porta;
-  // se nao for, faz out_port <- UNDEF e retorna.
-  // Armazena o valor bool3S com o resultado da simulacao (saida da porta)
-  // no dado "out_port" da porta
-  void simular(const std::vector<bool3S>& in_port);
+  // Retorna o valor bool3S com o resultado da simulacao (saida da porta),
+  // sem alterar o dado "out_port" da porta
+  // Se a dimensao do vetor in_port for diferente do numero de entradas da porta, retorna UNDEF
+  bool3S calcular(const std::vector<bool3S>& in_port) const;
 };
 
 class Port_NOR: public Port {
 public:
-  Port_NOR();
+  Port_NOR(std::pmr::memory_resource* Mem=std::pmr::get_default_resource());
+  Port_NOR(const Port_NOR& P, std::pmr::memory_resource* Mem);
   // Retorna new Port_NOR(*this)
   ptr_Port clone() const;
+  ptr_Port clone(std::pmr::memory_resource* Mem) const;
   // Retorna "NO"
   std::string getName() const;
+  // Retorna TipoPorta::NO
+  TipoPorta getTipo() const;
 
-  // Testa se a dimensao do vetor in_port eh igual ao numero de entradas da porta;
-  // se nao for, faz out_port <- UNDEF e retorna.
-  // Armazena o valor bool3S com o resultado da simulacao (saida da porta)
-  // no dado "out_port" da porta
-  void simular(const std::vector<bool3S>& in_port);
+  // Retorna o valor bool3S com o resultado da simulacao (saida da porta),
+  // sem alterar o dado "out_port" da porta
+  // Se a dimensao do vetor in_port for diferente do numero de entradas da porta, retorna UNDEF
+  bool3S calcular(const std::vector<bool3S>& in_port) const;
 };
 
 class Port_XOR: public Port {
 public:
-  Port_XOR();
+  Port_XOR(std::pmr::memory_resource* Mem=std::pmr::get_default_resource());
+  Port_XOR(const Port_XOR& P, std::pmr::memory_resource* Mem);
   // Retorna new Port_XOR(*this)
   ptr_Port clone() const;
+  ptr_Port clone(std::pmr::memory_resource* Mem) const;
   // Retorna "XO"
   std::string getName() const;
+  // Retorna TipoPorta::XO
+  TipoPorta getTipo() const;
 
-  // Testa se a dimensao do vetor in_port eh igual ao numero de entradas da porta;
-  // se nao for, faz out_port <- UNDEF e retorna.
-  // Armazena o valor bool3S com o resultado da simulacao (saida da porta)
-  // no dado "out_port" da porta
-  void simular(const std::vector<bool3S>& in_port);
+  // Retorna o valor bool3S com o resultado da simulacao (saida da porta),
+  // sem alterar o dado "out_port" da porta
+  // Se a dimensao do vetor in_port for diferente do numero de entradas da porta, retorna UNDEF
+  bool3S calcular(const std::vector<bool3S>& in_port) const;
 };
 
 class Port_NXOR: public Port {
 public:
-  Port_NXOR();
+  Port_NXOR(std::pmr::memory_resource* Mem=std::pmr::get_default_resource());
+  Port_NXOR(const Port_NXOR& P, std::pmr::memory_resource* Mem);
   // Retorna new Port_NXOR(*this)
   ptr_Port clone() const;
+  ptr_Port clone(std::pmr::memory_resource* Mem) const;
   // Retorna "NX"
   std::string getName() const;
+  // Retorna TipoPorta::NX
+  TipoPorta getTipo() const;
 
-  // Testa se a dimensao do vetor in_port eh igual ao numero de entradas da porta;
-  // se nao for, faz out_port <- UNDEF e retorna.
-  // Armazena o valor bool3S com o resultado da simulacao (saida da porta)
-  // no dado "out_port" da porta
-  void simular(const std::vector<bool3S>& in_port);
+  // Retorna o valor bool3S com o resultado da simulacao (saida da porta),
+  // sem alterar o dado "out_port" da porta
+  // Se a dimensao do vetor in_port for diferente do numero de entradas da porta, retorna UNDEF
+  bool3S calcular(const std::vector<bool3S>& in_port) const;
 };
 
 #endif // _PORT_H_
@@ -15,7 +15,7 @@
 // Construtor (recebe como parametro o numero de entradas da porta)
 // Dimensiona o array id_in e inicializa elementos com valor invalido (0),
 // inicializa out_port com UNDEF
-Port::Port(int NI):id_in(NI,0),out_port(bool3S::UNDEF)
+Port::Port(int NI, std::pmr::memory_resource* Mem):id_in(NI,0,Mem),out_port(bool3S::UNDEF)
 {
     // Nao pode testar o parametro NI com validNumInputs pq o construtor de
     // Port eh chamado pelo construtor de Port_NOT, mas sem que ocorra
@@ -30,9 +30,19 @@ Port::Port(int NI):id_in(NI,0),out_port(bool3S::UNDEF)
   */
 }
 
+// Construtor por copia com o vetor id_in alocado em Mem
+Port::Port(const Port& P, std::pmr::memory_resource* Mem):id_in(P.id_in,Mem),out_port(P.out_port) {}
+
 // Destrutor (nao faz nada)
 Port::~Port() {}
 
+// Destroi uma porta criada com criarPorta
+// A memoria eh da arena, e soh eh devolvida quando a arena for liberada
+void destruirPorta(ptr_Port P)
+{
+    if (P!=nullptr) P->~Port();
+}
+
 /// ***********************
 /// Funcoes de testagem
 /// ***********************
@@ -229,18 +239,39 @@ std::ostream& operator<<(std::ostream& O, const Port& X)
     return X.imprimir(O);
 };
 
+/// ***********************
+/// SIMULACAO (funcao principal da porta)
+/// ***********************
+
+// Simula uma porta logica, guardando o resultado em out_port
+// O calculo propriamente dito eh feito pelo metodo virtual calcular
+void Port::simular(const std::vector<bool3S>& in_port)
+{
+    if (!testValidSizeInputs(in_port)) return;
+    out_port = calcular(in_port);
+}
+
 ///PORT NOT
 //Construtor
-Port_NOT::Port_NOT(): Port(1){}
+Port_NOT::Port_NOT(std::pmr::memory_resource* Mem): Port(1, Mem){}
+Port_NOT::Port_NOT(const Port_NOT& P, std::pmr::memory_resource* Mem): Port(P, Mem){}
 //outras funes
 ptr_Port Port_NOT::clone() const{
     return new Port_NOT(*this);
 }
 
+ptr_Port Port_NOT::clone(std::pmr::memory_resource* Mem) const{
+    return criarPorta<Port_NOT>(Mem, *this);
+}
+
 std::string Port_NOT::getName() const{
     return "NT";
 }
 
+TipoPorta Port_NOT::getTipo() const{
+    return TipoPorta::NT;
+}
+
 bool Port_NOT::validNumInputs(int NI) const{
     if(NI != 1) return false;
     return true;
@@ -253,164 +284,173 @@ void Port_NOT::digitar(){
     id_in.at(0)=(id);
 }
 
-void Port_NOT::simular(const std::vector<bool3S>& in_port){
+bool3S Port_NOT::calcular(const std::vector<bool3S>& in_port) const{
     // SIMULAO DA PORTA:
     // PORTA NOT
-    if(in_port.size() != 1){
-        out_port = bool3S::UNDEF;
-    }else return;
-    out_port = ~in_port.at(0);
+    if(in_port.size() != 1) return bool3S::UNDEF;
+    return ~in_port[0];
 }
 ///FIM PORT NOT
 
 ///PORT AND
 //Construtor
-Port_AND::Port_AND(): Port(){}
+Port_AND::Port_AND(std::pmr::memory_resource* Mem): Port(2, Mem){}
+Port_AND::Port_AND(const Port_AND& P, std::pmr::memory_resource* Mem): Port(P, Mem){}
 //outras funes
 ptr_Port Port_AND::clone() const{
     return new Port_AND(*this);
 }
 
+ptr_Port Port_AND::clone(std::pmr::memory_resource* Mem) const{
+    return criarPorta<Port_AND>(Mem, *this);
+}
+
 std::string Port_AND::getName() const{
     return "AN";
 }
 
-void Port_AND::simular(const std::vector<bool3S>& in_port){
-    if(in_port.size() != unsigned(getNumInputs())){
-        out_port = bool3S::UNDEF;
-        return;
-    }
-    out_port = in_port.at(0);
-    for(int i=1; i < getNumInputs(); i++){
-        out_port &= in_port.at(i);
-    }
+TipoPorta Port_AND::getTipo() const{
+    return TipoPorta::AN;
+}
 
+bool3S Port_AND::calcular(const std::vector<bool3S>& in_port) const{
+    if(in_port.size() != unsigned(getNumInputs())) return bool3S::UNDEF;
+    return and3S(in_port.data(), getNumInputs());
 }
 ///FIM PORT AND
 
 ///PORT NAND
 //Construtor
-Port_NAND::Port_NAND(): Port(){}
+Port_NAND::Port_NAND(std::pmr::memory_resource* Mem): Port(2, Mem){}
+Port_NAND::Port_NAND(const Port_NAND& P, std::pmr::memory_resource* Mem): Port(P, Mem){}
 //outras funes
 ptr_Port Port_NAND::clone() const{
     return new Port_NAND(*this);
 }
 
+ptr_Port Port_NAND::clone(std::pmr::memory_resource* Mem) const{
+    return criarPorta<Port_NAND>(Mem, *this);
+}
+
 std::string Port_NAND::getName() const{
     return "NA";
 }
 
-void Port_NAND::simular(const std::vector<bool3S>& in_port){
-    if(in_port.size() != unsigned(getNumInputs())){
-        out_port = bool3S::UNDEF;
-        return;
-    }
-    out_port = in_port.at(0);
-    for(int i=1; i < getNumInputs(); i++){
-        out_port &= in_port.at(i);
-    }
-    out_port = ~out_port;
+TipoPorta Port_NAND::getTipo() const{
+    return TipoPorta::NA;
+}
 
+bool3S Port_NAND::calcular(const std::vector<bool3S>& in_port) const{
+    if(in_port.size() != unsigned(getNumInputs())) return bool3S::UNDEF;
+    return ~and3S(in_port.data(), getNumInputs());
 }
 ///FIM PORT NAND
 
 ///PORT OR
 //Construtor
-Port_OR::Port_OR(): Port(){}
+Port_OR::Port_OR(std::pmr::memory_resource* Mem): Port(2, Mem){}
+Port_OR::Port_OR(const Port_OR& P, std::pmr::memory_resource* Mem): Port(P, Mem){}
 //outras funes
 ptr_Port Port_OR::clone() const{
     return new Port_OR(*this);
 }
 
+ptr_Port Port_OR::clone(std::pmr::memory_resource* Mem) const{
+    return criarPorta<Port_OR>(Mem, *this);
+}
+
 std::string Port_OR::getName() const{
     return "OR";
 }
 
-void Port_OR::simular(const std::vector<bool3S>& in_port){
-    if(in_port.size() != unsigned(getNumInputs())){
-        out_port = bool3S::UNDEF;
-        return;
-    }
-    out_port = in_port.at(0);
-    for(int i=1; i < getNumInputs(); i++){
-        out_port |= in_port.at(i);
-    }
+TipoPorta Port_OR::getTipo() const{
+    return TipoPorta::OR;
+}
+
+bool3S Port_OR::calcular(const std::vector<bool3S>& in_port) const{
+    if(in_port.size() != unsigned(getNumInputs())) return bool3S::UNDEF;
+    return or3S(in_port.data(), getNumInputs());
 }
 ///FIM PORT OR
 
 ///PORT NOR
 //Construtor
-Port_NOR::Port_NOR(): Port(){}
+Port_NOR::Port_NOR(std::pmr::memory_resource* Mem): Port(2, Mem){}
+Port_NOR::Port_NOR(const Port_NOR& P, std::pmr::memory_resource* Mem): Port(P, Mem){}
 //outras funes
 ptr_Port Port_NOR::clone() const{
     return new Port_NOR(*this);
 }
 
+ptr_Port Port_NOR::clone(std::pmr::memory_resource* Mem) const{
+    return criarPorta<Port_NOR>(Mem, *this);
+}
+
 std::string Port_NOR::getName() const{
     return "NO";
 }
 
-void Port_NOR::simular(const std::vector<bool3S>& in_port){
-    if(in_port.size() != unsigned(getNumInputs())){
-        out_port = bool3S::UNDEF;
-        return;
-    }
-    out_port = in_port.at(0);
-    for(int i=1; i < getNumInputs(); i++){
-        out_port |= in_port.at(i);
-    }
-    out_port = ~out_port;
+TipoPorta Port_NOR::getTipo() const{
+    return TipoPorta::NO;
+}
 
+bool3S Port_NOR::calcular(const std::vector<bool3S>& in_port) const{
+    if(in_port.size() != unsigned(getNumInputs())) return bool3S::UNDEF;
+    return ~or3S(in_port.data(), getNumInputs());
 }
 ///FIM PORT NOR
 
 ///PORT XOR
 //Construtor
-Port_XOR::Port_XOR(){}
+Port_XOR::Port_XOR(std::pmr::memory_resource* Mem): Port(2, Mem){}
+Port_XOR::Port_XOR(const Port_XOR& P, std::pmr::memory_resource* Mem): Port(P, Mem){}
 //outras funes
 ptr_Port Port_XOR::clone() const{
     return new Port_XOR(*this);
 }
 
+ptr_Port Port_XOR::clone(std::pmr::memory_resource* Mem) const{
+    return criarPorta<Port_XOR>(Mem, *this);
+}
+
 std::string Port_XOR::getName() const{
     return "XO";
 }
 
-void Port_XOR::simular(const std::vector<bool3S>& in_port){
-    if(in_port.size() != unsigned(getNumInputs())){
-        out_port = bool3S::UNDEF;
-        return;
-    }
-    out_port = in_port.at(0);
-    for(int i=1; i < getNumInputs(); i++){
-        out_port ^= in_port.at(i);
-    }
+TipoPorta Port_XOR::getTipo() const{
+    return TipoPorta::XO;
+}
 
+bool3S Port_XOR::calcular(const std::vector<bool3S>& in_port) const{
+    if(in_port.size() != unsigned(getNumInputs())) return bool3S::UNDEF;
+    return xor3S(in_port.data(), getNumInputs());
 }
 ///FIM PORT XOR
 
 ///PORT NXOR
 //Construtor
-Port_NXOR::Port_NXOR(){}
+Port_NXOR::Port_NXOR(std::pmr::memory_resource* Mem): Port(2, Mem){}
+Port_NXOR::Port_NXOR(const Port_NXOR& P, std::pmr::memory_resource* Mem): Port(P, Mem){}
 //outras funes
 ptr_Port Port_NXOR::clone() const{
     return new Port_NXOR(*this);
 }
 
+ptr_Port Port_NXOR::clone(std::pmr::memory_resource* Mem) const{
+    return criarPorta<Port_NXOR>(Mem, *this);
+}
+
 std::string Port_NXOR::getName() const{
     return "NX";
 }
 
-void Port_NXOR::simular(const std::vector<bool3S>& in_port){
-    if(in_port.size() != unsigned(getNumInputs())){
-        out_port = bool3S::UNDEF;
-        return;
-    }
-    out_port = in_port.at(0);
-    for(int i=1; i < getNumInputs(); i++){
-        out_port ^= in_port.at(i);
-    }
-    out_port = ~out_port;
+TipoPorta Port_NXOR::getTipo() const{
+    return TipoPorta::NX;
+}
+
+bool3S Port_NXOR::calcular(const std::vector<bool3S>& in_port) const{
+    if(in_port.size() != unsigned(getNumInputs())) return bool3S::UNDEF;
+    return ~xor3S(in_port.data(), getNumInputs());
 }
 ///FIM PORT NXOR
 
@@ -0,0 +1,602 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "tabela.h"
+
+//Autores:  Luisa de Moura Galvão Mathias
+//          Marcos Paulo Barbosa
+
+// Numero maximo de trechos simulados que podem ficar esperando o consumidor,
+// por thread (limita a memoria usada quando o consumidor eh mais lento)
+const int TRECHOS_POR_THREAD = 4;
+
+// Retorna 3^Nin, ou 0 se Nin for invalido
+uint64_t numLinhasTabela(int Nin)
+{
+  if (Nin<=0 || Nin>MAX_ENTRADAS_TABELA) return 0;
+  uint64_t n = 1;
+  for (int i=0; i<Nin; i++) n *= 3;
+  return n;
+}
+
+// Retorna o valor da entrada de indice i na linha L (digito Nin-1-i de L na base 3)
+bool3S entradaLinha(uint64_t L, int Nin, int i)
+{
+  for (int k=Nin-1; k>i; k--) L /= 3;
+  switch (L%3)
+  {
+  case 1: return bool3S::FALSE;
+  case 2: return bool3S::TRUE;
+  default: return bool3S::UNDEF;
+  }
+}
+
+//
+// TRECHO DA TABELA
+//
+
+bool3S TrechoTabela::entrada(int k, int i) const
+{
+  return getBool3S(in_circ[i*num_palavras + k/64], k%64);
+}
+
+bool3S TrechoTabela::saida(int k, int j) const
+{
+  return getBool3S(out_circ[j*num_palavras + k/64], k%64);
+}
+
+// Monta as entradas das linhas inicio a inicio+num_linhas-1
+// Calcula os digitos da primeira linha e depois incrementa as entradas como em gerarTabela
+void montarTrecho(TrechoTabela& T, int Nin, uint64_t inicio, int num_linhas)
+{
+  std::vector<bool3S> in_circ(Nin);
+  int i, k;
+
+  T.inicio = inicio;
+  T.num_linhas = num_linhas;
+  T.num_palavras = (num_linhas+63)/64;
+  T.in_circ.assign(Nin*T.num_palavras, toBool3S_64(bool3S::UNDEF));
+
+  for (i=0; i<Nin; i++) in_circ[i] = entradaLinha(inicio, Nin, i);
+
+  for (k=0; k<num_linhas; k++)
+  {
+    for (i=0; i<Nin; i++)
+    {
+      if (in_circ[i]!=bool3S::UNDEF) setBool3S(T.in_circ[i*T.num_palavras + k/64], k%64, in_circ[i]);
+    }
+    i = Nin-1;
+    while (i>=0 && in_circ[i]==bool3S::TRUE)
+    {
+      in_circ[i]++;
+      i--;
+    }
+    if (i>=0) in_circ[i]++;
+  }
+}
+
+//
+// GERACAO EM PARALELO
+//
+
+bool gerarTabelaParalela(const Circuito& C, uint64_t inicio, uint64_t fim,
+                         const ConsumidorTabela& consumidor, int Nthreads,
+                         const std::atomic<bool>* cancelar)
+{
+  if (!C.prepararSimulacao()) return false;
+  uint64_t num_linhas = numLinhasTabela(C.getNumInputs());
+  if (num_linhas==0 || inicio>fim || fim>num_linhas) return false;
+  if (inicio==fim) return true;
+
+  const uint64_t num_trechos = (fim-inicio+LINHAS_TRECHO-1)/LINHAS_TRECHO;
+  if (Nthreads<=0) Nthreads = std::max(1u, std::thread::hardware_concurrency());
+  if (uint64_t(Nthreads)>num_trechos) Nthreads = int(num_trechos);
+  const int janela = TRECHOS_POR_THREAD*Nthreads;
+
+  // Os trechos prontos, guardados em uma fila circular indexada por (trecho % janela)
+  std::vector<TrechoTabela> prontos(janela);
+  std::vector<bool> pronto(janela, false);
+  uint64_t consumidos = 0;           // numero de trechos jah entregues ao consumidor
+  std::atomic<uint64_t> proximo(0);  // proximo trecho a ser simulado
+  std::mutex M;
+  std::condition_variable trecho_pronto, vaga_livre;
+  auto cancelada = [cancelar]{ return cancelar!=nullptr && cancelar->load(); };
+  bool parou = false;                // o consumidor parou (cancelamento ou excecao)
+
+  auto trabalhador = [&]()
+  {
+    // O contexto de simulacao e o trecho sao de cada thread
+    ContextoSimulacao Ctx;
+    TrechoTabela T;
+    uint64_t t;
+    C.prepararContexto(Ctx);
+
+    while (!cancelada() && (t = proximo.fetch_add(1)) < num_trechos)
+    {
+      {
+        // Espera ter espaco na fila para nao ficar muito aa frente do consumidor
+        std::unique_lock<std::mutex> trava(M);
+        vaga_livre.wait(trava, [&]{ return t < consumidos+janela || parou; });
+        if (parou) break;
+      }
+      uint64_t L = inicio + t*LINHAS_TRECHO;
+      montarTrecho(T, C.getNumInputs(), L, int(std::min<uint64_t>(LINHAS_TRECHO, fim-L)));
+      C.simularLote(T.in_circ, T.num_palavras, T.out_circ, Ctx);
+      {
+        std::lock_guard<std::mutex> trava(M);
+        std::swap(prontos[t%janela], T);
+        pronto[t%janela] = true;
+      }
+      trecho_pronto.notify_all();
+    }
+    {
+      // Acorda o consumidor, que pode estar esperando um trecho que nao serah simulado
+      std::lock_guard<std::mutex> trava(M);
+    }
+    trecho_pronto.notify_all();
+  };
+
+  std::vector<std::thread> threads;
+  for (int n=0; n<Nthreads; n++) threads.push_back(std::thread(trabalhador));
+
+  // Entrega os trechos ao consumidor na ordem
+  TrechoTabela T;
+  uint64_t t;
+  for (t=0; t<num_trechos; t++)
+  {
+    {
+      std::unique_lock<std::mutex> trava(M);
+      trecho_pronto.wait(trava, [&]{ return pronto[t%janela] || cancelada(); });
+      if (!pronto[t%janela] || cancelada())
+      {
+        // Libera as threads que estao esperando vaga na fila
+        parou = true;
+        break;
+      }
+      std::swap(prontos[t%janela], T);
+      pronto[t%janela] = false;
+    }
+    try
+    {
+      consumidor(T);
+    }
+    catch (...)
+    {
+      // Para as threads antes de repassar a excecao (destruir uma std::thread que
+      // ainda nao terminou chama std::terminate)
+      {
+        std::lock_guard<std::mutex> trava(M);
+        parou = true;
+      }
+      vaga_livre.notify_all();
+      trecho_pronto.notify_all();
+      for (unsigned n=0; n<threads.size(); n++) threads[n].join();
+      throw;
+    }
+    {
+      std::lock_guard<std::mutex> trava(M);
+      consumidos = t+1;
+    }
+    vaga_livre.notify_all();
+  }
+
+  vaga_livre.notify_all();
+
+  for (unsigned n=0; n<threads.size(); n++) threads[n].join();
+  return t==num_trechos;
+}
+
+//
+// ENUMERACAO EM CODIGO GRAY TERNARIO
+//
+
+EnumeradorGray::EnumeradorGray(int Nin, int NGray):
+  Nin(Nin), NGray(std::max(0, std::min(Nin, NGray))), in_circ(Nin, bool3S::UNDEF),
+  sentido(Nin, 1), peso(Nin), linha_atual(0)
+{
+  uint64_t p = 1;
+  for (int i=Nin-1; i>=0; i--)
+  {
+    peso[i] = p;
+    p *= 3;
+  }
+}
+
+bool EnumeradorGray::proximo()
+{
+  int i, v;
+
+  // Parte Gray: procura a entrada de menor peso que pode andar no seu sentido
+  for (i=Nin-1; i>=Nin-NGray; i--)
+  {
+    v = int(in_circ[i]) + sentido[i];
+    if (v>=0 && v<=2)
+    {
+      in_circ[i] = bool3S(v);
+      if (sentido[i]>0) linha_atual += peso[i];
+      else linha_atual -= peso[i];
+      return true;
+    }
+    sentido[i] = -sentido[i];
+  }
+
+  // A parte Gray percorreu todas as combinacoes (e inverteu os sentidos, para percorrer
+  // de volta): incrementa as demais entradas como em gerarTabela
+  for (i=Nin-NGray-1; i>=0 && in_circ[i]==bool3S::TRUE; i--)
+  {
+    in_circ[i] = bool3S::UNDEF;
+    linha_atual -= 2*peso[i];
+  }
+  if (i<0) return false;
+  in_circ[i]++;
+  linha_atual += peso[i];
+  return true;
+}
+
+bool gerarTabelaGray(const Circuito& C, OrdemTabela ordem, const ConsumidorLinha& consumidor)
+{
+  if (!C.prepararSimulacao() || numLinhasTabela(C.getNumInputs())==0) return false;
+
+  const int Nin = C.getNumInputs();
+  const int Nout = C.getNumOutputs();
+  ContextoSimulacao Ctx;
+  std::vector<bool3S> out_circ(Nout);
+  C.prepararContexto(Ctx);
+
+  if (ordem==OrdemTabela::GRAY)
+  {
+    EnumeradorGray E(Nin, Nin);
+    do
+    {
+      C.simularIncremental(E.entradas(), Ctx);
+      for (int j=0; j<Nout; j++) out_circ[j] = Ctx.getOutput(j+1);
+      consumidor(E.linha(), E.entradas(), out_circ);
+    } while (E.proximo());
+    return true;
+  }
+
+  // Cada grupo de tam_janela linhas em ordem Gray eh um intervalo da tabela: as saidas
+  // sao guardadas na posicao (linha % tam_janela) e entregues em ordem no fim do grupo
+  const int NGray = std::min(Nin, DIGITOS_JANELA_GRAY);
+  const uint64_t tam_janela = numLinhasTabela(NGray);
+  std::vector<bool3S> janela(tam_janela*Nout);
+  std::vector<bool3S> in_circ(Nin);
+  EnumeradorGray E(Nin, NGray);
+  uint64_t n = 0;
+  bool continua;
+
+  do
+  {
+    C.simularIncremental(E.entradas(), Ctx);
+    uint64_t k = E.linha()%tam_janela;
+    for (int j=0; j<Nout; j++) janela[k*Nout+j] = Ctx.getOutput(j+1);
+    uint64_t base = E.linha()-k;
+    continua = E.proximo();
+
+    if (++n == tam_janela)
+    {
+      for (int i=0; i<Nin; i++) in_circ[i] = entradaLinha(base, Nin, i);
+      for (k=0; k<tam_janela; k++)
+      {
+        for (int j=0; j<Nout; j++) out_circ[j] = janela[k*Nout+j];
+        consumidor(base+k, in_circ, out_circ);
+        int i = Nin-1;
+        while (i>=0 && in_circ[i]==bool3S::TRUE)
+        {
+          in_circ[i]++;
+          i--;
+        }
+        if (i>=0) in_circ[i]++;
+      }
+      n = 0;
+    }
+  } while (continua);
+  return true;
+}
+
+//
+// ENUMERACAO EM ARVORE
+//
+
+// Numero maximo de cubos guardados por uma gravacao da enumeracao na ordem da tabela
+// (limita a memoria usada quando a subarvore gravada tem muitos cubos)
+const size_t MAX_CUBOS_GRAVADOS = 65536;
+
+// Retorna, para cada saida do circuito C, as entradas das quais ela pode depender
+// atraves das ligacoes (bit i em 1 para a entrada de indice i)
+// As entradas de cada porta sao propagadas para as portas que a leem ateh estabilizar
+// (inclusive nos ciclos): uma porta soh volta para a fila quando ganha uma entrada nova,
+// de modo que cada porta eh processada no maximo Nin+1 vezes
+static std::vector<uint64_t> entradasDasSaidas(const Circuito& C)
+{
+  const int NP = C.getNumPorts();
+  std::vector<uint64_t> dep(NP, 0);
+  std::vector<std::vector<int>> leitores(NP);
+  for (int p=0; p<NP; p++)
+  {
+    for (int i=0; i<C.getNumInputsPort(p+1); i++)
+    {
+      int id = C.getId_inPort(p+1, i);
+      if (id<0) dep[p] |= uint64_t(1) << (-id-1);
+      else leitores[id-1].push_back(p);
+    }
+  }
+
+  std::vector<int> fila(NP);
+  std::vector<char> na_fila(NP, true);
+  for (int p=0; p<NP; p++) fila[p] = p;
+  while (!fila.empty())
+  {
+    int q = fila.back();
+    fila.pop_back();
+    na_fila[q] = false;
+    for (unsigned n=0; n<leitores[q].size(); n++)
+    {
+      int r = leitores[q][n];
+      if ((dep[r] | dep[q]) == dep[r]) continue;
+      dep[r] |= dep[q];
+      if (!na_fila[r])
+      {
+        na_fila[r] = true;
+        fila.push_back(r);
+      }
+    }
+  }
+
+  std::vector<uint64_t> dep_saida(C.getNumOutputs());
+  for (int j=0; j<C.getNumOutputs(); j++)
+  {
+    int id = C.getIdOutput(j+1);
+    dep_saida[j] = (id<0 ? uint64_t(1) << (-id-1) : dep[id-1]);
+  }
+  return dep_saida;
+}
+
+// Estado da enumeracao em arvore de gerarCubos e gerarTabelaArvore
+// Cada no fixa uma entrada ainda livre em UNDEF, FALSE e TRUE. Soh sao usadas as entradas
+// das quais alguma saida ainda UNDEF pode depender (entradasDasSaidas): se nao sobrar
+// nenhuma, as saidas nao mudam mais e o no eh um cubo
+// - em gerarCubos (ordem_tabela false), as entradas das quais nenhuma saida UNDEF depende
+//   sao puladas e ficam livres no cubo, de modo que o '-' pode aparecer em qualquer
+//   posicao e o resultado nao depende da ordem das entradas;
+// - em gerarTabelaArvore (ordem_tabela true), as entradas sao fixadas na ordem da tabela.
+//   Quando nenhuma saida UNDEF depende da entrada do no, os tres filhos tem as mesmas
+//   saidas linha a linha: os cubos do filho UNDEF sao gravados e repetidos para os outros
+//   dois, sem simular. Se a gravacao passar de MAX_CUBOS_GRAVADOS cubos, os cubos sao
+//   entregues e os outros filhos sao simulados normalmente
+// Os cubos completos sao guardados em pendentes enquanto ainda podem ser juntados: quando
+// os tres filhos de um no terminam em um cubo cada, com as mesmas saidas, os tres viram
+// um soh cubo (o do no). Quando um no nao pode mais virar um cubo, todos os cubos
+// pendentes (que vem antes das linhas que faltam percorrer) sao entregues
+struct EnumeracaoArvore {
+  // Os cubos entregues durante a percurso do filho UNDEF de um no cuja entrada nao muda
+  // as saidas. Os cubos pendentes de indice menor que antes sao anteriores ao no, e por
+  // isso nao sao gravados. Se ativa for false, a gravacao estourou e os cubos sao
+  // entregues diretamente
+  struct Gravacao {
+    std::vector<CuboTabela> cubos;
+    bool ativa;
+    unsigned antes;
+  };
+
+  const Circuito& C;
+  const ConsumidorCubo& consumidor;
+  const int Nin, Nout;
+  const bool ordem_tabela;
+  // As entradas das quais cada saida pode depender
+  const std::vector<uint64_t> dep_saida;
+  ContextoSimulacao Ctx;
+  // As entradas do no atual: as fixadas e as livres (UNDEF)
+  std::vector<bool3S> in_circ;
+  std::vector<bool> fixada;
+  // Os cubos pendentes sao pendentes[0] a pendentes[num_pendentes-1]
+  std::vector<CuboTabela> pendentes;
+  unsigned num_pendentes;
+  // A pilha de gravacoes (uma para cada no em que os cubos estao sendo repetidos)
+  std::vector<Gravacao> gravacoes;
+  uint64_t num_simuladas;
+
+  EnumeracaoArvore(const Circuito& C, const ConsumidorCubo& consumidor, bool ordem_tabela):
+    C(C), consumidor(consumidor), Nin(C.getNumInputs()), Nout(C.getNumOutputs()),
+    ordem_tabela(ordem_tabela), dep_saida(entradasDasSaidas(C)), Ctx(),
+    in_circ(Nin, bool3S::UNDEF), fixada(Nin, false), pendentes(), num_pendentes(0),
+    gravacoes(), num_simuladas(0) {}
+
+  // Simula a linha das entradas in_circ
+  void simular()
+  {
+    C.simularIncremental(in_circ, Ctx);
+    num_simuladas++;
+  }
+
+  // Percorre o no em que as entradas de indice menor que d jah foram fixadas (ou
+  // puladas), cuja linha eh L e que acabou de ser simulado (as saidas estao em Ctx)
+  // Retorna true se todas as linhas do no tem as mesmas saidas (o no virou um cubo
+  // pendente); false se os cubos do no jah foram entregues
+  bool percorrer(int d, uint64_t L)
+  {
+    // As entradas a partir de d das quais alguma saida UNDEF pode depender
+    uint64_t cone = 0;
+    for (int j=0; j<Nout; j++) if (Ctx.getOutput(j+1)==bool3S::UNDEF) cone |= dep_saida[j];
+    cone &= ~((uint64_t(1) << d) - 1);
+    if (!ordem_tabela) while (d<Nin && !((cone >> d) & 1)) d++;
+
+    if (cone==0)
+    {
+      // Folha, ou subarvore determinada: um cubo com as saidas da linha do no
+      if (num_pendentes==pendentes.size()) pendentes.push_back(CuboTabela());
+      CuboTabela& Cubo = pendentes[num_pendentes++];
+      Cubo.inicio = L;
+      Cubo.in_circ = in_circ;
+      Cubo.livre.resize(Nin);
+      for (int i=0; i<Nin; i++) Cubo.livre[i] = !fixada[i];
+      Cubo.out_circ.resize(Nout);
+      for (int j=0; j<Nout; j++) Cubo.out_circ[j] = Ctx.getOutput(j+1);
+      return true;
+    }
+
+    // Numero de linhas da tabela entre os filhos do no
+    uint64_t peso = 1;
+    for (int i=d+1; i<Nin; i++) peso *= 3;
+    unsigned primeiro = num_pendentes;
+    fixada[d] = true;
+
+    if (!((cone >> d) & 1)) return repetir(d, L, peso);
+
+    // O filho UNDEF tem a mesma linha (e as mesmas saidas) que o no; os outros sao simulados
+    bool cubo = percorrer(d+1, L);
+    for (int v=1; v<=2; v++)
+    {
+      in_circ[d] = bool3S(v);
+      simular();
+      cubo = percorrer(d+1, L+v*peso) && cubo;
+    }
+    in_circ[d] = bool3S::UNDEF;
+    fixada[d] = false;
+
+    if (cubo && pendentes[primeiro].out_circ==pendentes[primeiro+1].out_circ &&
+        pendentes[primeiro].out_circ==pendentes[primeiro+2].out_circ)
+    {
+      // O cubo do filho UNDEF (que comeca na linha L) passa a ser o do no
+      pendentes[primeiro].livre[d] = true;
+      num_pendentes = primeiro+1;
+      return true;
+    }
+    entregarPendentes();
+    return false;
+  }
+
+  // Percorre o no de percorrer cuja entrada d nao muda nenhuma saida (soh na ordem da
+  // tabela): simula o filho UNDEF gravando os seus cubos e repete-os para os outros
+  bool repetir(int d, uint64_t L, uint64_t peso)
+  {
+    unsigned primeiro = num_pendentes;
+    gravacoes.push_back(Gravacao{std::vector<CuboTabela>(), true, num_pendentes});
+    bool cubo = percorrer(d+1, L);
+    Gravacao G = std::move(gravacoes.back());
+    gravacoes.pop_back();
+
+    if (cubo)
+    {
+      // Os tres filhos tem as mesmas saidas: o cubo do filho UNDEF passa a ser o do no
+      // (nada foi gravado, pois nenhum cubo foi entregue)
+      fixada[d] = false;
+      pendentes[primeiro].livre[d] = true;
+      return true;
+    }
+    if (G.ativa)
+    {
+      for (int v=0; v<=2; v++)
+      {
+        for (unsigned n=0; n<G.cubos.size(); n++)
+        {
+          if (v>0)
+          {
+            G.cubos[n].in_circ[d] = bool3S(v);
+            G.cubos[n].inicio += peso;
+          }
+          entregar(G.cubos[n], gravacoes.size());
+        }
+      }
+    }
+    else
+    {
+      for (int v=1; v<=2; v++)
+      {
+        in_circ[d] = bool3S(v);
+        simular();
+        percorrer(d+1, L+v*peso);
+      }
+      in_circ[d] = bool3S::UNDEF;
+      entregarPendentes();
+    }
+    fixada[d] = false;
+    return false;
+  }
+
+  // Entrega Cubo na gravacao ativa mais interna entre as nivel primeiras da pilha, ou ao
+  // consumidor se nao houver nenhuma
+  void entregar(const CuboTabela& Cubo, size_t nivel)
+  {
+    while (nivel>0 && !gravacoes[nivel-1].ativa) nivel--;
+    if (nivel==0)
+    {
+      consumidor(Cubo);
+      return;
+    }
+    Gravacao& G = gravacoes[nivel-1];
+    G.cubos.push_back(Cubo);
+    if (G.cubos.size() > MAX_CUBOS_GRAVADOS)
+    {
+      G.ativa = false;
+      for (unsigned n=0; n<G.cubos.size(); n++) entregar(G.cubos[n], nivel-1);
+      std::vector<CuboTabela>().swap(G.cubos);
+    }
+  }
+
+  // Entrega os cubos pendentes, cada um na gravacao do no mais interno que ele pertence
+  void entregarPendentes()
+  {
+    size_t nivel = 0;
+    for (unsigned n=0; n<num_pendentes; n++)
+    {
+      while (nivel<gravacoes.size() && gravacoes[nivel].antes<=n) nivel++;
+      entregar(pendentes[n], nivel);
+    }
+    num_pendentes = 0;
+    for (unsigned g=0; g<gravacoes.size(); g++) gravacoes[g].antes = 0;
+  }
+};
+
+// Percorre a arvore de linhas do circuito C (ver EnumeracaoArvore), entregando os cubos a
+// consumidor
+static bool percorrerArvore(const Circuito& C, bool ordem_tabela, const ConsumidorCubo& consumidor,
+                            uint64_t* num_simuladas)
+{
+  if (!C.prepararSimulacao() || numLinhasTabela(C.getNumInputs())==0) return false;
+
+  EnumeracaoArvore E(C, consumidor, ordem_tabela);
+  C.prepararContexto(E.Ctx);
+
+  // A raiz eh a linha 0 (todas as entradas UNDEF)
+  E.simular();
+  E.percorrer(0, 0);
+  E.entregarPendentes();
+
+  if (num_simuladas!=nullptr) *num_simuladas = E.num_simuladas;
+  return true;
+}
+
+bool gerarCubos(const Circuito& C, const ConsumidorCubo& consumidor, uint64_t* num_simuladas)
+{
+  return percorrerArvore(C, false, consumidor, num_simuladas);
+}
+
+bool gerarTabelaArvore(const Circuito& C, const ConsumidorLinha& consumidor,
+                       uint64_t* num_simuladas)
+{
+  const int Nin = C.getNumInputs();
+  std::vector<bool3S> in_circ;
+
+  // Cada cubo eh expandido nas suas linhas: as entradas livres (as ultimas, na ordem da
+  // tabela) sao incrementadas como em gerarTabela, a partir de todas UNDEF
+  return percorrerArvore(C, true, [&](const CuboTabela& Cubo)
+  {
+    uint64_t num_linhas = 1;
+    for (int i=0; i<Nin; i++) if (Cubo.livre[i]) num_linhas *= 3;
+    in_circ = Cubo.in_circ;
+    for (uint64_t k=0; k<num_linhas; k++)
+    {
+      consumidor(Cubo.inicio+k, in_circ, Cubo.out_circ);
+      int i = Nin-1;
+      while (i>=0 && (!Cubo.livre[i] || in_circ[i]==bool3S::TRUE))
+      {
+        if (Cubo.livre[i]) in_circ[i]++;
+        i--;
+      }
+      if (i>=0) in_circ[i]++;
+    }
+  }, num_simuladas);
+}
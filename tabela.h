@@ -0,0 +1,203 @@
+#ifndef _TABELA_H_
+#define _TABELA_H_
+
+//Autores:  Luisa de Moura Galvão Mathias
+//          Marcos Paulo Barbosa
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "bool3S.h"
+#include "bool3S_64.h"
+#include "circuito.h"
+
+/// ###########################################################################
+/// GERACAO DA TABELA VERDADE
+/// As linhas da tabela sao numeradas de 0 a 3^Nin-1, na mesma ordem em que sao
+/// geradas pelo incremento das entradas (operator++): a linha L tem como entradas
+/// os digitos de L na base 3, sendo o mais significativo a entrada de id -1 e o
+/// menos significativo a entrada de id -Nin, com 0=UNDEF, 1=FALSE e 2=TRUE
+/// ###########################################################################
+
+// Maior numero de entradas para o qual o numero de linhas (3^Nin) cabe em 64 bits
+const int MAX_ENTRADAS_TABELA = 40;
+
+// Numero de linhas de cada trecho da tabela (multiplo de 64)
+const int LINHAS_TRECHO = 4096;
+
+// Retorna o numero de linhas da tabela verdade de um circuito com Nin entradas (3^Nin)
+// ou 0 se Nin for invalido (<=0 ou >MAX_ENTRADAS_TABELA)
+uint64_t numLinhasTabela(int Nin);
+
+// Retorna o valor da entrada de indice i (id -(i+1)) na linha L de uma tabela com Nin entradas
+bool3S entradaLinha(uint64_t L, int Nin, int i);
+
+//
+// UM TRECHO DA TABELA VERDADE
+//
+
+// Linhas consecutivas da tabela verdade, com entradas e saidas no formato de
+// Circuito::simularLote: 64 linhas em cada bool3S_64
+struct TrechoTabela {
+  // Indice da primeira linha do trecho na tabela
+  uint64_t inicio;
+  // Numero de linhas do trecho (de 1 a LINHAS_TRECHO)
+  int num_linhas;
+  // Numero de elementos bool3S_64 por entrada ou saida (num_linhas/64 arredondado para cima)
+  int num_palavras;
+  // in_circ[i*num_palavras+w]: bits das linhas inicio+64*w a inicio+64*w+63 da entrada -(i+1)
+  std::vector<bool3S_64> in_circ;
+  // out_circ[j*num_palavras+w]: idem para a saida j+1
+  std::vector<bool3S_64> out_circ;
+
+  // Valor da entrada de indice i (id -(i+1)) na linha inicio+k
+  bool3S entrada(int k, int i) const;
+  // Valor da saida de indice j (id j+1) na linha inicio+k
+  bool3S saida(int k, int j) const;
+};
+
+// Monta as entradas de num_linhas linhas consecutivas da tabela de um circuito com
+// Nin entradas, a partir da linha inicio, e dimensiona o trecho
+void montarTrecho(TrechoTabela& T, int Nin, uint64_t inicio, int num_linhas);
+
+// Funcao que recebe os trechos da tabela, sempre em ordem crescente de linha
+typedef std::function<void(const TrechoTabela&)> ConsumidorTabela;
+
+// Gera as linhas de inicio a fim-1 da tabela verdade do circuito C, dividindo o intervalo
+// em trechos de LINHAS_TRECHO linhas que sao simulados por Nthreads threads (0: numero de
+// processadores da maquina). Cada thread simula o mesmo circuito com o seu proprio
+// ContextoSimulacao, de modo que o circuito nao eh copiado nem alterado durante a geracao
+// Os trechos sao entregues a consumidor em ordem, sempre na thread que chamou a funcao
+// Apenas um numero limitado de trechos fica guardado esperando o consumidor
+// Se cancelar nao for nullptr, a geracao para (sem entregar os trechos seguintes) assim
+// que *cancelar passar a ser true, o que pode ser feito por outra thread
+// Se consumidor lancar uma excecao, as threads sao paradas e a excecao eh repassada
+// Retorna false se o circuito for invalido, tiver mais de MAX_ENTRADAS_TABELA entradas,
+// o intervalo de linhas for invalido ou a geracao tiver sido cancelada antes de entregar
+// todos os trechos
+bool gerarTabelaParalela(const Circuito& C, uint64_t inicio, uint64_t fim,
+                         const ConsumidorTabela& consumidor, int Nthreads=0,
+                         const std::atomic<bool>* cancelar=nullptr);
+
+//
+// ENUMERACAO EM CODIGO GRAY TERNARIO
+//
+
+// Percorre as 3^Nin combinacoes de entrada de forma que linhas consecutivas diferem
+// em uma unica entrada (codigo Gray ternario refletido): a cada passo, a entrada de
+// menor peso que ainda pode andar no seu sentido (UNDEF->FALSE->TRUE ou o contrario)
+// muda de valor, e todas as entradas de menor peso invertem o sentido
+// Apenas as NGray entradas de menor peso (ids -(Nin-NGray+1) a -Nin) seguem o codigo
+// Gray; as demais sao incrementadas como em gerarTabela cada vez que as NGray
+// entradas percorrem todas as suas combinacoes. Assim, cada grupo de 3^NGray linhas
+// consecutivas corresponde a um intervalo de linhas da tabela em ordem lexicografica
+// Com NGray==Nin, todas as linhas consecutivas diferem em uma unica entrada
+class EnumeradorGray {
+private:
+  int Nin, NGray;
+  // Os valores atuais das entradas
+  std::vector<bool3S> in_circ;
+  // O sentido em que cada entrada anda (+1 ou -1)
+  std::vector<int> sentido;
+  // peso[i] = 3^(Nin-1-i)
+  std::vector<uint64_t> peso;
+  // O indice (na ordem lexicografica) da linha atual
+  uint64_t linha_atual;
+
+public:
+  // Comeca na linha 0 (todas as entradas UNDEF)
+  EnumeradorGray(int Nin, int NGray);
+
+  // As entradas da linha atual
+  const std::vector<bool3S>& entradas() const { return in_circ; }
+  // O indice da linha atual na tabela (ordem lexicografica, como em entradaLinha)
+  uint64_t linha() const { return linha_atual; }
+
+  // Passa para a proxima linha. Retorna false se todas as linhas jah foram percorridas
+  bool proximo();
+};
+
+// Ordem em que as linhas sao entregues por gerarTabelaGray
+enum class OrdemTabela {
+  // A ordem da tabela (linha 0, 1, 2, ...): as linhas sao simuladas em grupos de
+  // 3^DIGITOS_JANELA_GRAY linhas em ordem Gray e reordenadas antes de serem entregues
+  LEXICOGRAFICA,
+  // A ordem em que as linhas sao simuladas (cada linha difere da anterior em uma
+  // unica entrada)
+  GRAY
+};
+
+// Numero de entradas que seguem o codigo Gray em OrdemTabela::LEXICOGRAFICA
+// (grupos de 3^7=2187 linhas guardadas ateh serem reordenadas)
+const int DIGITOS_JANELA_GRAY = 7;
+
+// Funcao que recebe uma linha da tabela: o indice da linha (ordem lexicografica),
+// as entradas e as saidas do circuito
+typedef std::function<void(uint64_t, const std::vector<bool3S>&,
+                           const std::vector<bool3S>&)> ConsumidorLinha;
+
+// Gera a tabela verdade do circuito C percorrendo as entradas em codigo Gray e
+// simulando com Circuito::simularIncremental, de modo que cada linha soh resimula as
+// portas afetadas pela entrada que mudou. As linhas sao entregues a consumidor na
+// ordem pedida (sempre na thread que chamou a funcao)
+// Retorna false se o circuito for invalido ou tiver entradas demais
+bool gerarTabelaGray(const Circuito& C, OrdemTabela ordem, const ConsumidorLinha& consumidor);
+
+//
+// ENUMERACAO EM ARVORE
+//
+
+// Um cubo da tabela verdade: as linhas em que as entradas fixadas tem os valores de
+// in_circ e as entradas livres tem qualquer valor (UNDEF, FALSE ou TRUE), todas com as
+// saidas out_circ
+struct CuboTabela {
+  // Indice da linha do cubo em que as entradas livres sao UNDEF
+  uint64_t inicio;
+  // Os valores das entradas (Nin valores; os das entradas livres sao UNDEF)
+  std::vector<bool3S> in_circ;
+  // livre[i] eh true se a entrada de indice i pode ter qualquer valor
+  std::vector<bool> livre;
+  // As saidas de todas as linhas do cubo
+  std::vector<bool3S> out_circ;
+};
+
+// Funcao que recebe os cubos da tabela
+typedef std::function<void(const CuboTabela&)> ConsumidorCubo;
+
+// Gera a tabela verdade do circuito C como uma lista de cubos, percorrendo as linhas
+// como uma arvore ternaria: cada no eh uma linha com algumas entradas fixadas e as
+// demais UNDEF, e os filhos fixam mais uma entrada em UNDEF, FALSE e TRUE
+// Como os operadores de bool3S sao monotonos (trocar uma entrada UNDEF por FALSE ou
+// TRUE nunca muda uma saida jah definida), soh as saidas UNDEF do no ainda podem mudar,
+// e soh atraves das entradas das quais elas dependem pelas ligacoes do circuito. Por
+// isso, cada no fixa a proxima entrada (na ordem das ids) de que alguma saida UNDEF
+// depende: as entradas puladas ficam livres no cubo (em qualquer posicao), e quando
+// nao sobra nenhuma (por exemplo, quando todas as saidas sao definidas) o no eh um
+// cubo, sem simular os descendentes. Soh as linhas dos nos sao simuladas (com
+// Circuito::simularIncremental), e nenhuma linha eh simulada mais de uma vez
+// Alem disso, quando os tres filhos de um no resultam em um cubo cada, com as mesmas
+// saidas, os tres sao juntados no cubo do no
+// Cada linha da tabela estah em exatamente um cubo. A lista nao eh necessariamente a
+// menor possivel (dois cubos soh sao juntados quando sao filhos do mesmo no, e a ordem
+// em que as entradas sao fixadas eh a das ids), mas os cubos sao entregues a consumidor
+// durante a enumeracao, sem guardar a tabela. Os cubos saem na ordem da arvore, que soh
+// eh a ordem das linhas quando nenhuma entrada eh pulada
+// Se num_simuladas nao for nullptr, recebe o numero de linhas que foram simuladas
+// Retorna false se o circuito for invalido ou tiver entradas demais
+bool gerarCubos(const Circuito& C, const ConsumidorCubo& consumidor,
+                uint64_t* num_simuladas=nullptr);
+
+// Gera a tabela verdade do circuito C linha a linha, com a mesma arvore de gerarCubos,
+// mas fixando as entradas sempre na ordem da tabela, de modo que cada cubo eh um
+// intervalo de linhas e os cubos saem em ordem de linha. Quando nenhuma saida UNDEF de
+// um no depende da entrada que ele fixa, os tres filhos tem as mesmas saidas linha a
+// linha: soh o filho UNDEF eh simulado, e os seus cubos sao repetidos para os outros
+// (ateh um limite de cubos guardados; acima dele, os outros filhos sao simulados)
+// As linhas sao entregues a consumidor na ordem da tabela (linha 0, 1, 2, ...)
+// Se num_simuladas nao for nullptr, recebe o numero de linhas que foram simuladas
+// Retorna false se o circuito for invalido ou tiver entradas demais
+bool gerarTabelaArvore(const Circuito& C, const ConsumidorLinha& consumidor,
+                       uint64_t* num_simuladas=nullptr);
+
+#endif // _TABELA_H_